@@ -0,0 +1,161 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the latency of autocommit catalog writes (SetMetadata, SetLastLocked) and of
+// reads (GetMetadata, IsAppInstalled) for each database profile. Run it on the storage
+// the catalog lives on, the sync cost dominates the writes on flash. The last column is the
+// wall time per GetMetadata call with READ_THREADS threads reading at once. The list columns
+// count all installed apps once through GetAppDetailsList and once through VisitAppDetails.
+//
+// usage: CatalogBenchmark [root directory] [operations per run]
+
+#include "SqlDataStorage.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr unsigned int APP_COUNT = 100;
+    constexpr unsigned int READ_THREADS = 4;
+    const std::string TYPE{"application/dac.native"};
+
+    struct Profile
+    {
+        std::string name;
+        packagemanager::DatabaseProfile settings;
+    };
+
+    std::string appId(unsigned int i)
+    {
+        return "com.benchmark.app" + std::to_string(i % APP_COUNT);
+    }
+
+    double perCall(unsigned int calls, const std::function<void(unsigned int)> &call)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < calls; ++i)
+        {
+            call(i);
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / calls;
+    }
+
+    double perCallConcurrent(unsigned int calls, const std::function<void(unsigned int)> &call)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < READ_THREADS; ++t)
+        {
+            threads.emplace_back([&call, calls, t]()
+            {
+                for (unsigned int i = t; i < calls; i += READ_THREADS)
+                {
+                    call(i);
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / calls;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string root = argc > 1 ? argv[1] : "/tmp/catalog_benchmark";
+    unsigned int calls = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    using packagemanager::JournalMode;
+    using packagemanager::SyncLevel;
+    using packagemanager::TempStore;
+    std::vector<Profile> profiles{
+        {"delete full (default)", {JournalMode::DELETE, SyncLevel::FULL, 0, -2000, TempStore::DEFAULT}},
+        {"wal full", {JournalMode::WAL, SyncLevel::FULL, 0, -2000, TempStore::DEFAULT}},
+        {"wal normal", {JournalMode::WAL, SyncLevel::NORMAL, 0, -2000, TempStore::DEFAULT}},
+        {"wal normal mmap 4M", {JournalMode::WAL, SyncLevel::NORMAL, 4 * 1024 * 1024, -2000, TempStore::MEMORY}},
+    };
+
+    std::cout << "profile\tSetMetadata [us]\tSetLastLocked [us]\tGetMetadata [us]\tIsAppInstalled [us]\tGetMetadata concurrent [us]\tGetAppDetailsList [us]\tVisitAppDetails [us]" << std::endl;
+    for (const auto &profile : profiles)
+    {
+        if (system(("rm -rf " + root + " && mkdir -p " + root).c_str()) != 0)
+        {
+            std::cerr << "unable to prepare " << root << std::endl;
+            return EXIT_FAILURE;
+        }
+        packagemanager::SqlDataStorage storage(root + "/", profile.settings);
+        storage.Initialize(packagemanager::DataStorage::IntegrityCheck::NONE);
+        for (unsigned int i = 0; i < APP_COUNT; ++i)
+        {
+            auto id = appId(i);
+            storage.AddInstalledApp(TYPE, id, "1.0", "", id, "", "apps/" + id + "/1.0/", "data/" + id + "/");
+        }
+
+        auto setMetadata = perCall(calls, [&](unsigned int i)
+        {
+            storage.SetMetadata(TYPE, appId(i), "1.0", "key" + std::to_string(i % 10), std::to_string(i));
+        });
+        auto setLastLocked = perCall(calls, [&](unsigned int i)
+        {
+            storage.SetLastLocked(appId(i), "1.0", i);
+        });
+        auto getMetadata = perCall(calls, [&](unsigned int i)
+        {
+            storage.GetMetadata(TYPE, appId(i), "1.0");
+        });
+        auto isInstalled = perCall(calls, [&](unsigned int i)
+        {
+            storage.IsAppInstalled(TYPE, appId(i), "1.0");
+        });
+        auto concurrentGetMetadata = perCallConcurrent(calls, [&](unsigned int i)
+        {
+            storage.GetMetadata(TYPE, appId(i), "1.0");
+        });
+        std::size_t listed{};
+        auto list = perCall(calls, [&](unsigned int)
+        {
+            listed += storage.GetAppDetailsList("", "", "", "", "").size();
+        });
+        std::size_t visited{};
+        auto visit = perCall(calls, [&](unsigned int)
+        {
+            storage.VisitAppDetails([&visited](const packagemanager::DataStorage::AppDetailsView &)
+            {
+                ++visited;
+                return true;
+            }, false, "", "", "", "", "");
+        });
+        if (listed != visited)
+        {
+            std::cerr << "GetAppDetailsList listed " << listed << " apps, VisitAppDetails " << visited << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << profile.name << '\t' << setMetadata << '\t' << setLastLocked << '\t' << getMetadata << '\t' << isInstalled
+                  << '\t' << concurrentGetMetadata << '\t' << list << '\t' << visit << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
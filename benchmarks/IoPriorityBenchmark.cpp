@@ -0,0 +1,197 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the latency of small random reads of a foreground reader (an app loading its assets)
+// while a background writer streams and syncs data like an install does, with the writer
+// running at the caller's priority and with a background priority profile.
+// The io class only makes a difference with the bfq io scheduler on the device under test.
+//
+// usage: IoPriorityBenchmark [directory] [seconds per run]
+
+#include "ThreadPriority.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    constexpr size_t READ_SIZE = 4096;
+    constexpr size_t WRITE_CHUNK = 4 * 1024 * 1024;
+    constexpr off_t READ_FILE_SIZE = 256LL * 1024 * 1024;
+
+    void createReadFile(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            std::cerr << "unable to create " << path << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        std::vector<char> chunk(WRITE_CHUNK, 'r');
+        for (off_t written = 0; written < READ_FILE_SIZE; written += WRITE_CHUNK)
+        {
+            if (write(fd, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size()))
+            {
+                exit(EXIT_FAILURE);
+            }
+        }
+        fsync(fd);
+        close(fd);
+    }
+
+    // streams chunks with a sync every 16 MiB, until stopped
+    void backgroundWriter(const std::string &path, const packagemanager::PriorityProfile &profile, const std::atomic<bool> &stop)
+    {
+        packagemanager::ScopedThreadPriority scopedPriority{profile};
+        std::vector<char> chunk(WRITE_CHUNK, 'w');
+        unsigned int chunks{0};
+        while (!stop)
+        {
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            for (unsigned int i = 0; i < 64 && !stop && fd >= 0; ++i)
+            {
+                if (write(fd, chunk.data(), chunk.size()) < 0)
+                {
+                    break;
+                }
+                if (++chunks % 4 == 0)
+                {
+                    fdatasync(fd);
+                }
+            }
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        unlink(path.c_str());
+    }
+
+    struct Latencies
+    {
+        double p50;
+        double p99;
+        double max;
+        size_t reads;
+    };
+
+    Latencies foregroundReads(const std::string &path, double seconds)
+    {
+        // O_DIRECT so that every read reaches the device, not the page cache
+        int fd = open(path.c_str(), O_RDONLY | O_DIRECT);
+        bool direct = fd >= 0;
+        if (!direct)
+        {
+            fd = open(path.c_str(), O_RDONLY);
+        }
+        void *buffer{nullptr};
+        if (fd < 0 || posix_memalign(&buffer, READ_SIZE, READ_SIZE) != 0)
+        {
+            std::cerr << "unable to read " << path << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        std::mt19937_64 random{42};
+        std::uniform_int_distribution<off_t> block(0, READ_FILE_SIZE / READ_SIZE - 1);
+        std::vector<double> samples;
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end)
+        {
+            off_t offset = block(random) * READ_SIZE;
+            if (!direct)
+            {
+                posix_fadvise(fd, offset, READ_SIZE, POSIX_FADV_DONTNEED);
+            }
+            auto start = std::chrono::steady_clock::now();
+            if (pread(fd, buffer, READ_SIZE, offset) != static_cast<ssize_t>(READ_SIZE))
+            {
+                break;
+            }
+            samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            // an app does not read back to back
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        free(buffer);
+        close(fd);
+
+        std::sort(samples.begin(), samples.end());
+        if (samples.empty())
+        {
+            return Latencies{0, 0, 0, 0};
+        }
+        return Latencies{samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back(), samples.size()};
+    }
+
+    Latencies measure(const std::string &directory, double seconds, const packagemanager::PriorityProfile *profile)
+    {
+        std::atomic<bool> stop{false};
+        std::thread writer;
+        if (profile)
+        {
+            writer = std::thread(backgroundWriter, directory + "/background.bin", std::cref(*profile), std::cref(stop));
+        }
+        auto latencies = foregroundReads(directory + "/foreground.bin", seconds);
+        stop = true;
+        if (writer.joinable())
+        {
+            writer.join();
+        }
+        return latencies;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string directory = argc > 1 ? argv[1] : "/tmp/iopriority_benchmark";
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 10.0;
+    if (system(("mkdir -p " + directory).c_str()) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+    createReadFile(directory + "/foreground.bin");
+
+    packagemanager::PriorityProfile caller{};
+    packagemanager::PriorityProfile bestEffortLow{true, packagemanager::IoClass::BEST_EFFORT, 7, 10};
+    packagemanager::PriorityProfile idle{true, packagemanager::IoClass::IDLE, 7, 19};
+
+    struct Run
+    {
+        const char *name;
+        const packagemanager::PriorityProfile *profile;
+    };
+    std::cout << "writer\treads\tp50 [ms]\tp99 [ms]\tmax [ms]" << std::endl;
+    for (const auto &run : {Run{"none", nullptr}, Run{"caller priority", &caller},
+                            Run{"best-effort 7, nice 10", &bestEffortLow}, Run{"idle, nice 19", &idle}})
+    {
+        auto latencies = measure(directory, seconds, run.profile);
+        std::cout << run.name << '\t' << latencies.reads << '\t' << latencies.p50 << '\t' << latencies.p99 << '\t'
+                  << latencies.max << std::endl;
+    }
+    unlink((directory + "/foreground.bin").c_str());
+    return EXIT_SUCCESS;
+}
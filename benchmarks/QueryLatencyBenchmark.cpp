@@ -0,0 +1,130 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the per call latency of small catalog queries, with the statement prepared and
+// finalized on every call (as SqlDataStorage did before the statement cache) and with a
+// cached statement, followed by the SqlDataStorage methods themselves.
+//
+// usage: QueryLatencyBenchmark [root directory] [calls]
+
+#include "SqlDataStorage.h"
+#include "StatementCache.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sqlite3.h>
+#include <string>
+
+namespace
+{
+    constexpr unsigned int APP_COUNT = 200;
+    const std::string TYPE{"application/dac.native"};
+    const std::string IS_INSTALLED_QUERY{"SELECT idx FROM installed_apps WHERE app_idx IN (SELECT idx FROM apps WHERE (?1 IS NULL OR type = ?1) AND app_id = ?2 AND version = ?3);"};
+
+    std::string appId(unsigned int i)
+    {
+        return "com.benchmark.app" + std::to_string(i % APP_COUNT);
+    }
+
+    void bindAndStep(sqlite3_stmt *stmt, unsigned int i)
+    {
+        auto id = appId(i);
+        sqlite3_bind_text(stmt, 1, TYPE.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, "1.0", -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_ROW)
+        {
+            std::cerr << "query failed" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    void report(const std::string &name, unsigned int calls, const std::function<void(unsigned int)> &call)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < calls; ++i)
+        {
+            call(i);
+        }
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        std::cout << name << '\t' << elapsed.count() / calls << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string root = argc > 1 ? argv[1] : "/tmp/query_benchmark";
+    unsigned int calls = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    if (system(("rm -rf " + root + " && mkdir -p " + root).c_str()) != 0)
+    {
+        std::cerr << "unable to prepare " << root << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    packagemanager::SqlDataStorage storage(root + "/");
+    storage.Initialize(packagemanager::DataStorage::IntegrityCheck::NONE);
+    for (unsigned int i = 0; i < APP_COUNT; ++i)
+    {
+        auto id = appId(i);
+        storage.AddInstalledApp(TYPE, id, "1.0", "", id, "", "apps/" + id + "/1.0/", "data/" + id + "/");
+        storage.SetMetadata(TYPE, id, "1.0", "key", "value");
+    }
+
+    sqlite3 *connection{};
+    if (sqlite3_open((root + "/apps.db").c_str(), &connection) != SQLITE_OK)
+    {
+        std::cerr << "unable to open the catalog" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "query\tlatency [us]" << std::endl;
+    report("IsAppInstalled prepare per call", calls, [&](unsigned int i)
+    {
+        sqlite3_stmt *stmt{};
+        sqlite3_prepare_v2(connection, IS_INSTALLED_QUERY.c_str(), IS_INSTALLED_QUERY.length(), &stmt, nullptr);
+        bindAndStep(stmt, i);
+        sqlite3_finalize(stmt);
+    });
+
+    packagemanager::StatementCache cache;
+    cache.reset(connection);
+    report("IsAppInstalled cached statement", calls, [&](unsigned int i)
+    {
+        packagemanager::StatementCache::Statement stmt{cache, IS_INSTALLED_QUERY};
+        bindAndStep(stmt, i);
+    });
+    cache.reset(nullptr);
+    sqlite3_close(connection);
+
+    report("SqlDataStorage::IsAppInstalled", calls, [&](unsigned int i)
+    {
+        storage.IsAppInstalled(TYPE, appId(i), "1.0");
+    });
+    report("SqlDataStorage::GetAppsPaths", calls, [&](unsigned int i)
+    {
+        storage.GetAppsPaths(TYPE, appId(i), "1.0");
+    });
+    report("SqlDataStorage::GetMetadata", calls, [&](unsigned int i)
+    {
+        storage.GetMetadata(TYPE, appId(i), "1.0");
+    });
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures how long Executor::Configure blocks for a catalog of N installed apps,
+// with the full startup and with the lazy startup after a clean and after an unclean shutdown.
+//
+// usage: StartupBenchmark [root directory] [app count...]
+
+#include "Executor.h"
+#include "Filesystem.h"
+#include "SqlDataStorage.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::string configFor(const std::string &root, const std::string &startupMode)
+    {
+        return R"({"appspath":")" + root + R"(/apps","dbpath":")" + root + R"(","datapath":")" + root +
+               R"(/data","annotationsFile":"config.json","annotationsRegex":"public\\.*","startupMode":")" +
+               startupMode + R"("})";
+    }
+
+    void populate(const std::string &root, unsigned int count)
+    {
+        if (system(("rm -rf " + root + " && mkdir -p " + root + "/0").c_str()) != 0)
+        {
+            std::cerr << "unable to prepare " << root << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        {
+            // creates the catalog and the directory layout
+            packagemanager::Executor executor;
+            executor.Configure(configFor(root, "full"));
+        }
+
+        packagemanager::SqlDataStorage storage(root + "/0/");
+        storage.Initialize(packagemanager::DataStorage::IntegrityCheck::NONE);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            std::string id = "com.benchmark.app" + std::to_string(i);
+            // relative to the apps and data paths, like a real install records them
+            std::string appSubPath = packagemanager::Filesystem::createAppPath(id, "1.0");
+            std::string appPath = root + "/apps/" + appSubPath;
+            if (system(("mkdir -p " + appPath).c_str()) != 0)
+            {
+                exit(EXIT_FAILURE);
+            }
+            std::ofstream(appPath + "config.json") << "{}";
+            storage.AddInstalledApp("application/dac.native", id, "1.0", "", id, "", appSubPath, packagemanager::Filesystem::createAppPath(id));
+            storage.SetAppUsage("application/dac.native", id, "1.0", {{"config.json", 2, 8}});
+        }
+    }
+
+    double measure(const std::string &root, const std::string &startupMode, bool cleanShutdown)
+    {
+        if (!cleanShutdown)
+        {
+            // drops the clean shutdown marker written by the previous run
+            std::ofstream(root + "/0/journal", std::ios::trunc);
+        }
+
+        packagemanager::Executor executor;
+        auto start = std::chrono::steady_clock::now();
+        executor.Configure(configFor(root, startupMode));
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        return elapsed.count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string root = argc > 1 ? argv[1] : "/tmp/startup_benchmark";
+    std::vector<unsigned int> counts;
+    for (int i = 2; i < argc; ++i)
+    {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty())
+    {
+        counts = {10, 100, 1000};
+    }
+
+    std::cout << "apps\tfull [ms]\tlazy clean [ms]\tlazy unclean [ms]" << std::endl;
+    for (auto count : counts)
+    {
+        populate(root, count);
+        double full = measure(root, "full", true);
+        double lazyClean = measure(root, "lazy", true);
+        double lazyUnclean = measure(root, "lazy", false);
+        std::cout << count << '\t' << full << '\t' << lazyClean << '\t' << lazyUnclean << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace packagemanager
+{
+
+    /**
+     * In-memory model of the <id>/<version>/ directories below the apps root,
+     * kept up to date from inotify events instead of listing the tree.
+     * Events are drained whenever the model is read, so it reflects every change
+     * made before the call. The tree is only listed again after the kernel
+     * event queue overflowed.
+     */
+    class AppsWatcher
+    {
+    public:
+        using AppDirectories = std::map<std::string, std::set<std::string>>; // id -> versions
+
+        explicit AppsWatcher(const std::string &appsRoot);
+        ~AppsWatcher();
+
+        AppsWatcher(const AppsWatcher &) = delete;
+        AppsWatcher &operator=(const AppsWatcher &) = delete;
+
+        // Sets up the watches and the initial model, false if inotify is not usable
+        bool start();
+
+        AppDirectories getAppDirectories();
+
+    private:
+        void drainEvents();
+        void rescan();
+        void watchId(const std::string &id);
+        void unwatchId(const std::string &id);
+
+        const std::string appsRoot;
+        int inotifyFd{-1};
+        int rootWatch{-1};
+        bool overflowed{false};
+
+        std::mutex mutex{};
+        std::unordered_map<int, std::string> watchedIds{};
+        std::unordered_map<std::string, int> idWatches{};
+        AppDirectories apps{};
+    };
+
+} // namespace packagemanager
@@ -20,19 +20,65 @@
 
 #pragma once
 
+#include "Filesystem.h"
+
+#include <functional>
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 namespace packagemanager
 {
     namespace Archive
     {
+        /**
+         * Owner and mode applied to every extracted entry while it is created,
+         * the mode follows Filesystem::permissionMode.
+         */
+        struct Ownership
+        {
+            int uid{-1};
+            int gid{-1};
+            bool writeable{false};
+        };
+
         /**
          * Given a compressed archive in tar.gz format, this function will extract the content to the destinationPath
          * @param archivePath Full path of the archive
          * @param destinationPath Full path to the destination directory
+         * @param manifest Optional, filled with the regular files extracted and their on-disk size
+         * @param ownership Optional, overrides owner and mode stored in the archive
+         * @param betweenEntries Optional, called before each entry after the first, may block to throttle
          * @return int  1 if the extraction succeeeds, 0 otherwise
          */
-        int unpackArchive(const std::string &filePath, const std::string &destinationDir);
+        int unpackArchive(const std::string &filePath, const std::string &destinationDir,
+                          std::vector<Filesystem::FileUsage> *manifest = nullptr,
+                          const Ownership *ownership = nullptr,
+                          const std::function<void()> &betweenEntries = {});
+
+        /**
+         * Packs a directory tree into a zstd compressed tar archive, paths are stored relative
+         * to sourceDir so that unpackArchive recreates the tree below any destination.
+         * The archive is synced to disk before returning.
+         * @param compressionLevel zstd level, decompression speed barely depends on it
+         * @param betweenEntries Optional, called before each entry after the first, may block to throttle
+         * @return int  1 if the archive was written completely, 0 otherwise
+         */
+        int packArchive(const std::string &sourceDir, const std::string &archivePath, int compressionLevel,
+                        const std::function<void()> &betweenEntries = {});
+
+        /**
+         * Digest::sha256Tree of the regular files in an archive, comparable with
+         * Filesystem::getTreeDigest of the directory it was extracted to.
+         * @return empty if the archive can not be read
+         */
+        std::string getContentDigest(const std::string &archivePath);
+
+        /**
+         * Cheap estimate of the space needed to extract an archive without reading it:
+         * the uncompressed size from the gzip trailer (modulo 4 GiB), the file size otherwise.
+         * @return 0 if the archive can not be read
+         */
+        unsigned long long getUnpackedSizeEstimate(const std::string &archivePath);
     } // namespace Archive
 } // namespace packagemanager
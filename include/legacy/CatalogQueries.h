@@ -0,0 +1,42 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "FilteredQuery.h"
+
+namespace packagemanager
+{
+    // Catalog lookups with optional filters, used by SqlDataStorage
+    namespace CatalogQueries
+    {
+        // filters: type, app_id
+        extern const FilteredQuery<2> APP_DATA;
+        extern const FilteredQuery<2> DATA_PATHS;
+
+        // filters: type, app_id, version
+        extern const FilteredQuery<3> APPS_PATHS;
+        extern const FilteredQuery<3> APPS_LOCATIONS;
+
+        // filters: type, app_id, version, name, category
+        extern const FilteredQuery<5> APP_DETAILS;
+        extern const FilteredQuery<5> APP_DETAILS_OUTER_JOIN;
+    }
+
+} // namespace packagemanager
@@ -0,0 +1,110 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "DataStorage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace packagemanager
+{
+
+    /**
+     * Immutable copy of the app list (GetAppDetailsListOuterJoin) of one catalog generation.
+     * All strings live in one arena, each distinct string once, so the type and category
+     * repeated across the rows cost nothing. Shared read-only between callers, the views
+     * stay valid as long as the snapshot is held. Rows are indexed by id and by id and
+     * version, the catalog lookups of Lock and Install need no query while it is current.
+     */
+    class CatalogSnapshot
+    {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        CatalogSnapshot(const CatalogSnapshot &) = delete;
+        CatalogSnapshot &operator=(const CatalogSnapshot &) = delete;
+
+        // The generation is read before the scan, a write during it only causes a rebuild later
+        static std::shared_ptr<const CatalogSnapshot> build(DataStorage &storage);
+
+        unsigned long long generation() const { return catalogGeneration; }
+        std::size_t size() const { return rows.size(); }
+        DataStorage::AppDetailsView operator[](std::size_t row) const;
+
+        // A row of the app, npos if it is not in the catalog
+        std::size_t find(const std::string &id) const;
+        // The row of the installed version, npos if it is not installed
+        std::size_t find(const std::string &id, const std::string &version) const;
+
+        // Bytes of string data stored
+        std::size_t arenaSize() const { return arena.size(); }
+
+    private:
+        struct Span
+        {
+            std::uint32_t offset;
+            std::uint32_t size;
+        };
+
+        struct Row
+        {
+            Span type;
+            Span id;
+            Span version;
+            Span appName;
+            Span category;
+            Span url;
+            Span volume;
+            Span path;
+            bool hibernated;
+        };
+
+        using Key = std::pair<DataStorage::TextView, DataStorage::TextView>;
+
+        struct TextHash
+        {
+            std::size_t operator()(const DataStorage::TextView &text) const;
+            std::size_t operator()(const Key &key) const;
+        };
+
+        struct TextEqual
+        {
+            bool operator()(const DataStorage::TextView &a, const DataStorage::TextView &b) const;
+            bool operator()(const Key &a, const Key &b) const;
+        };
+
+        CatalogSnapshot() = default;
+        DataStorage::TextView text(const Span &span) const { return DataStorage::TextView{arena.data() + span.offset, span.size}; }
+
+        unsigned long long catalogGeneration{};
+        std::string arena{};
+        std::vector<Row> rows{};
+        // keys point into the arena, which is complete before they are added
+        std::unordered_map<DataStorage::TextView, std::size_t, TextHash, TextEqual> byId{};
+        std::unordered_map<Key, std::size_t, TextHash, TextEqual> byIdVersion{};
+    };
+
+} // namespace packagemanager
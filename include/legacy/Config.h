@@ -20,6 +20,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace packagemanager
 {
@@ -30,6 +31,108 @@ namespace packagemanager
     const std::string DACBUNDLEPLATFORMNAMEOVERRIDE_KEY_NAME{"dacBundlePlatformNameOverride"};
     const std::string DACBUNDLEFIRMWARECOMPATIBILITYKEY_KEY_NAME{"dacBundleFirmwareCompatibilityKey"};
     const std::string CONFIG_URL_KEY_NAME{"configUrl"};
+    const std::string APPS_TMP_DIR_NAME{"tmp"};
+    const std::string APPS_TRASH_DIR_NAME{"trash"};
+    const std::string APPS_HIBERNATED_DIR_NAME{"hibernated"};
+
+    enum class StartupMode
+    {
+        FULL, // integrity_check and reconciliation before Configure returns
+        LAZY  // quick_check (none after a clean shutdown), expensive checks in the background
+    };
+
+    enum class VolumeSpeed
+    {
+        FAST,
+        SLOW
+    };
+
+    // Install time hint on how often an app is expected to be launched
+    enum class UsageHint
+    {
+        DEFAULT,
+        FREQUENT,
+        RARE
+    };
+
+    // Who waits for a job, background jobs run with Config::getBackgroundPriority
+    enum class JobPriority
+    {
+        BACKGROUND,
+        FOREGROUND // e.g. a user initiated install, runs with the caller's priority
+    };
+
+    enum class IoClass
+    {
+        BEST_EFFORT,
+        IDLE // only gets disk time no other process wants
+    };
+
+    /**
+     * Io scheduling class and nice value for the thread running a job. The io class
+     * only takes effect with an io scheduler that supports priorities (bfq).
+     */
+    struct PriorityProfile
+    {
+        bool enabled{false};
+        IoClass ioClass{IoClass::IDLE};
+        int ioLevel{7}; // 0 (highest) to 7, best effort only
+        int nice{10};
+    };
+
+    enum class JournalMode
+    {
+        DELETE, // rollback journal, sqlite's default
+        WAL     // readers do not block the writer, a commit syncs once
+    };
+
+    enum class SyncLevel
+    {
+        OFF,
+        NORMAL, // with WAL a power loss may drop the last commits, never corrupts
+        FULL
+    };
+
+    enum class TempStore
+    {
+        DEFAULT,
+        FILE,
+        MEMORY
+    };
+
+    /**
+     * Pragmas of the catalog database connection, the defaults are sqlite's own.
+     */
+    struct DatabaseProfile
+    {
+        JournalMode journalMode{JournalMode::DELETE};
+        SyncLevel synchronous{SyncLevel::FULL};
+        long long mmapSize{0};    // bytes of the database mapped, 0 disables mmap
+        long long cacheSize{-2000}; // pages if positive, KiB if negative
+        TempStore tempStore{TempStore::DEFAULT};
+        unsigned int readConnections{4}; // read-only connections besides the writer, WAL only
+    };
+
+    enum class EvictionPolicy
+    {
+        NONE, // installs fail when no app volume has enough space
+        LRU   // least recently locked, unlocked versions are removed to make room
+    };
+
+    /**
+     * A filesystem apps are installed to. Every volume has its own tmp and trash
+     * directories so that staging and removal stay renames on the same filesystem.
+     */
+    struct AppVolume
+    {
+        std::string name{};       // recorded in the catalog, empty for appspath
+        std::string path{};
+        std::string tmpPath{};
+        std::string trashPath{};
+        std::string hibernatedPath{}; // compressed archives of hibernated app versions
+        VolumeSpeed speed{VolumeSpeed::FAST};
+        unsigned long long capacity{0}; // bytes apps may use on the volume, 0 for no limit
+    };
 
     class Config
     {
@@ -40,6 +143,7 @@ namespace packagemanager
         const std::string &getDatabasePath() const;
         const std::string &getAppsTmpPath() const;
         const std::string &getAppsPath() const;
+        const std::string &getAppsTrashPath() const;
         const std::string &getAnnotationsFile() const;
         const std::string &getAnnotationsRegex() const;
         unsigned int getDownloadRetryAfterSeconds() const;
@@ -48,6 +152,34 @@ namespace packagemanager
         const std::string &getDacBundlePlatformNameOverride() const;
         const std::string &getDacBundleFirmwareCompatibilityKey() const;
         const std::string &getConfigUrl() const;
+        StartupMode getStartupMode() const;
+        bool getWatchAppsPath() const;
+
+        // appspath first, followed by the configured "appVolumes"
+        const std::vector<AppVolume> &getAppVolumes() const;
+        const AppVolume *findAppVolume(const std::string &name) const;
+
+        EvictionPolicy getEvictionPolicy() const;
+        // free space kept on top of the install size when evicting
+        unsigned long long getEvictionReserve() const;
+        // only versions with a newer version of the same app installed are evicted
+        bool getEvictSupersededOnly() const;
+
+        // "backgroundPriority": {"ioClass": "idle" | "best-effort", "ioLevel": 7, "nice": 10}
+        const PriorityProfile &getBackgroundPriority() const;
+
+        // "database": {"journalMode": "wal", "synchronous": "normal", "mmapSizeKB": 4096, "cacheSizeKB": 2000, "tempStore": "memory", "readConnections": 4}
+        const DatabaseProfile &getDatabaseProfile() const;
+
+        // seconds an app version has to be unused before it is hibernated, 0 if hibernation is off
+        unsigned long long getHibernateAfter() const;
+        // versions whose last rehydration took longer are not hibernated again, 0 for no limit
+        unsigned long long getMaxRehydrationTime() const;
+
+        // ms background installs and hibernation pause after a launch (Lock), 0 if they never pause
+        unsigned long long getInteractiveWindow() const;
+        // longest total pause of one background job in ms
+        unsigned long long getMaxBackgroundPause() const;
 
         friend std::ostream &operator<<(std::ostream &out, const Config &config);
 
@@ -55,11 +187,24 @@ namespace packagemanager
         std::string databasePath;
         std::string appsPath;
         std::string appsTmpPath;
+        std::string appsTrashPath;
         std::string annotationsFile;
         std::string annotationsRegex;
         std::string dacBundlePlatformNameOverride;
         std::string dacBundleFirmwareCompatibilityKey;
         std::string configUrl;
+        StartupMode startupMode{StartupMode::FULL};
+        bool watchAppsPath{false};
+        std::vector<AppVolume> appVolumes;
+        EvictionPolicy evictionPolicy{EvictionPolicy::NONE};
+        unsigned long long evictionReserve{0};
+        bool evictSupersededOnly{true};
+        PriorityProfile backgroundPriority{};
+        DatabaseProfile databaseProfile{};
+        unsigned long long hibernateAfter{0};
+        unsigned long long maxRehydrationTime{0};
+        unsigned long long interactiveWindow{0};
+        unsigned long long maxBackgroundPause{30000};
     };
 
 } // namespace packagemanager
@@ -0,0 +1,120 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "StatementCache.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sqlite3.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace packagemanager
+{
+
+    /**
+     * Connections to one sqlite database: a single writer and a pool of read-only
+     * connections, each with its own statement cache. The connections are opened with
+     * SQLITE_OPEN_NOMUTEX, a connection is only used by the thread holding its lease.
+     * Readers only help in WAL mode, with maxReaders 0 every lease is the writer's.
+     */
+    class ConnectionPool
+    {
+        struct Connection
+        {
+            sqlite3 *db{nullptr};
+            StatementCache statements{};
+        };
+
+    public:
+        // Connection checked out for the scope, converts to sqlite3 * for the sqlite3 calls
+        class Lease
+        {
+        public:
+            Lease(Lease &&other);
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+            Lease &operator=(Lease &&) = delete;
+            ~Lease();
+
+            operator sqlite3 *() const { return connection->db; }
+            StatementCache &statements() const { return connection->statements; }
+            // Marks the write as one that stales what readers cached, see generation()
+            void invalidate() const;
+
+        private:
+            friend class ConnectionPool;
+            Lease(ConnectionPool &pool, Connection *connection, bool writer);
+
+            ConnectionPool *pool;
+            Connection *connection;
+            bool writer;
+        };
+
+        ConnectionPool() = default;
+        ConnectionPool(const ConnectionPool &) = delete;
+        ConnectionPool &operator=(const ConnectionPool &) = delete;
+        ~ConnectionPool();
+
+        /**
+         * Opens the writer, readers are opened on first use.
+         * @param readerSetup statements run on every reader after opening it, e.g. pragmas
+         * throws DataStorageError if the database can not be opened
+         */
+        void open(const std::string &path, unsigned int maxReaders, const std::string &readerSetup = {});
+        // All leases must have been returned
+        void close();
+
+        // Waits for other threads writing, reentrant for the thread holding it
+        Lease writer();
+        // The writer for the thread holding it, its own writes are visible then
+        Lease reader();
+
+        std::size_t openReaders() const;
+
+        // Advances when the outermost writer lease that was invalidated is returned, and on open
+        unsigned long long generation() const { return writeGeneration; }
+
+    private:
+        static sqlite3 *openConnection(const std::string &path, int flags);
+        void release(Connection *connection, bool writer);
+
+        std::string path{};
+        unsigned int maxReaders{0};
+        std::string readerSetup{};
+
+        std::unique_ptr<Connection> writerConnection{};
+        std::recursive_mutex writerMutex{};
+        std::atomic<std::thread::id> writerOwner{};
+        unsigned int writerDepth{0};
+        bool writerInvalidated{false};
+        std::atomic<unsigned long long> writeGeneration{0};
+
+        mutable std::mutex readersMutex{};
+        std::condition_variable readerReturned{};
+        std::vector<std::unique_ptr<Connection>> readers{};
+        std::vector<Connection *> idleReaders{};
+    };
+
+} // namespace packagemanager
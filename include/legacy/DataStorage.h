@@ -19,7 +19,14 @@
 
 #pragma once
 
+#include "Filesystem.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <utility>
 #include <stdexcept>
 #include <vector>
 
@@ -63,11 +70,139 @@ namespace packagemanager
             std::vector<std::pair<std::string, std::string> > metadata;
         };
 
+        // Installed app directory, path is relative to the root of the app volume
+        struct AppLocation
+        {
+            std::string volume;
+            std::string path;
+            bool hibernated{false}; // path is absent, the app is packed in the volume's hibernatedPath
+        };
+
+        // An installed version and where it is, see GetInstalledApps
+        struct InstalledApp
+        {
+            AppDetails details;
+            AppLocation location;
+            bool usageRecorded; // see GetAppUsage
+        };
+
+        // Column text inside the current row of a scan, only valid until the visitor returns
+        struct TextView
+        {
+            const char *data;
+            std::size_t size;
+
+            std::string str() const { return std::string(data, size); }
+            bool empty() const { return size == 0; }
+            bool operator==(const std::string &text) const { return text.compare(0, std::string::npos, data, size) == 0; }
+            bool operator!=(const std::string &text) const { return !(*this == text); }
+        };
+
+        // A row of VisitAppDetails, the columns of AppDetails and AppLocation without copying them
+        struct AppDetailsView
+        {
+            TextView type;
+            TextView id;
+            TextView version;
+            TextView appName;
+            TextView category;
+            TextView url;
+            // empty for an app without an installed version, see GetAppDetailsListOuterJoin
+            TextView volume;
+            TextView path;
+            bool hibernated;
+
+            AppLocation location() const
+            {
+                AppLocation location;
+                location.volume = volume.str();
+                location.path = path.str();
+                location.hibernated = hibernated;
+                return location;
+            }
+
+            AppDetails str() const
+            {
+                AppDetails details;
+                details.type = type.str();
+                details.id = id.str();
+                details.version = version.str();
+                details.appName = appName.str();
+                details.category = category.str();
+                details.url = url.str();
+                return details;
+            }
+        };
+
+        // Called for each row of a scan, returns false to stop it
+        using AppDetailsVisitor = std::function<bool(const AppDetailsView &)>;
+
+        struct AppUsage
+        {
+            unsigned long long bytes{};
+            unsigned long long blocks{};
+        };
+
+        // An installed version in least recently used order, see GetEvictionCandidates
+        struct EvictionCandidate
+        {
+            std::string type;
+            std::string id;
+            std::string version;
+            AppUsage usage;
+            bool usageRecorded;
+            long long lastLocked; // seconds since epoch, 0 if never locked
+            bool superseded;      // a newer version of the app is installed
+        };
+
+        // An extracted version not locked since a given time, see GetHibernationCandidates
+        struct HibernationCandidate
+        {
+            std::string type;
+            std::string id;
+            std::string version;
+            long long lastLocked;       // seconds since epoch of the last Lock (or install)
+            long long rehydrationTime;  // milliseconds the last rehydration took, -1 if never hibernated
+        };
+
+        enum class IntegrityCheck
+        {
+            FULL,  // PRAGMA integrity_check
+            QUICK, // PRAGMA quick_check, O(N) instead of O(N log N), no index verification
+            NONE
+        };
+
+        /**
+         * Unit of work: the writes made while it exists are committed together by commit(),
+         * or rolled back when it is destroyed without. Transactions nest, a nested commit
+         * only takes effect with the outermost one. Other threads' writes wait for it.
+         */
+        class Transaction
+        {
+        public:
+            virtual ~Transaction() {}
+            virtual void commit() = 0;
+        };
+
+        using MetadataValues = std::vector<std::pair<std::string, std::string>>;
+
         virtual ~DataStorage() {}
-        virtual void Initialize() = 0;
+        virtual void Initialize(IntegrityCheck check) = 0;
+        virtual std::unique_ptr<Transaction> BeginTransaction() = 0;
+        // Full integrity check on a separate connection, may run concurrently with other calls
+        virtual bool CheckIntegrity() = 0;
+        // true if Initialize had to create an empty catalog (new or dropped database)
+        virtual bool WasCreated() const = 0;
+        // Advances when installed versions are added, removed or hibernated, a CatalogSnapshot is valid for one generation
+        virtual unsigned long long GetGeneration() const = 0;
         virtual std::vector<std::string> GetAppsPaths(const std::string &type = {},
                                                       const std::string &id = {},
                                                       const std::string &version = {}) = 0;
+        virtual std::vector<AppLocation> GetAppsLocations(const std::string &type = {},
+                                                          const std::string &id = {},
+                                                          const std::string &version = {}) = 0;
+        // Every installed version with its location in one query, instead of a GetAppsLocations per app
+        virtual std::vector<InstalledApp> GetInstalledApps() = 0;
         virtual std::vector<std::string> GetDataPaths(const std::string &type = {},
                                                       const std::string &id = {}) = 0;
         virtual std::vector<AppDetails> GetAppDetailsList(const std::string &type = {},
@@ -80,6 +215,14 @@ namespace packagemanager
                                                                    const std::string &version = {},
                                                                    const std::string &appName = {},
                                                                    const std::string &category = {}) = 0;
+        // Streams the rows of GetAppDetailsList, or of GetAppDetailsListOuterJoin if outerJoin, nothing is allocated per row
+        virtual void VisitAppDetails(const AppDetailsVisitor &visitor,
+                                     bool outerJoin,
+                                     const std::string &type = {},
+                                     const std::string &id = {},
+                                     const std::string &version = {},
+                                     const std::string &appName = {},
+                                     const std::string &category = {}) = 0;
 
         virtual void AddInstalledApp(const std::string &type,
                                      const std::string &id,
@@ -88,7 +231,8 @@ namespace packagemanager
                                      const std::string &appName,
                                      const std::string &category,
                                      const std::string &appPath,
-                                     const std::string &appStoragePath) = 0;
+                                     const std::string &appStoragePath,
+                                     const std::string &volume = {}) = 0;
 
         virtual bool IsAppInstalled(const std::string &type,
                                     const std::string &id,
@@ -113,6 +257,12 @@ namespace packagemanager
                                  const std::string &key,
                                  const std::string &value) = 0;
 
+        // Sets all values in one transaction, either all of them or none
+        virtual void SetMetadata(const std::string &type,
+                                 const std::string &id,
+                                 const std::string &version,
+                                 const MetadataValues &values) = 0;
+
         virtual void ClearMetadata(const std::string &type,
                                    const std::string &id,
                                    const std::string &version,
@@ -122,6 +272,48 @@ namespace packagemanager
                                         const std::string &id,
                                         const std::string &version) = 0;
 
+        // Replaces the file manifest of an installed app and updates its total size
+        virtual void SetAppUsage(const std::string &type,
+                                 const std::string &id,
+                                 const std::string &version,
+                                 const std::vector<Filesystem::FileUsage> &manifest) = 0;
+
+        // Returns false when no usage was recorded yet for the installed app
+        virtual bool GetAppUsage(const std::string &type,
+                                 const std::string &id,
+                                 const std::string &version,
+                                 AppUsage &usage) = 0;
+
+        virtual AppUsage GetTotalUsage() = 0;
+        virtual AppUsage GetVolumeUsage(const std::string &volume) = 0;
+
+        virtual void SetLastLocked(const std::string &id,
+                                   const std::string &version,
+                                   long long timestamp) = 0;
+
+        // Extracted versions installed on the volume, least recently installed or locked first
+        virtual std::vector<EvictionCandidate> GetEvictionCandidates(const std::string &volume) = 0;
+
+        virtual void SetHibernated(const std::string &id,
+                                   const std::string &version,
+                                   bool hibernated) = 0;
+
+        virtual void SetRehydrationTime(const std::string &id,
+                                        const std::string &version,
+                                        long long milliseconds) = 0;
+
+        // sha256 of the archive a version was installed from
+        virtual void SetArchiveDigest(const std::string &id,
+                                      const std::string &version,
+                                      const std::string &digest) = 0;
+
+        // Empty if the version is not installed or was installed before digests were recorded
+        virtual std::string GetArchiveDigest(const std::string &id,
+                                             const std::string &version) = 0;
+
+        // Extracted versions not locked since lockedBefore, least recently locked first
+        virtual std::vector<HibernationCandidate> GetHibernationCandidates(long long lockedBefore) = 0;
+
         friend std::ostream &operator<<(std::ostream &out,
                                         const AppDetails &details)
         {
@@ -0,0 +1,69 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace packagemanager
+{
+    namespace Digest
+    {
+        /**
+         * Incremental SHA-256 (FIPS 180-4), used to identify app archives.
+         */
+        class Sha256
+        {
+        public:
+            Sha256();
+
+            void update(const void *data, std::size_t length);
+
+            // lowercase hex digest, the object has to be reset before it is reused
+            std::string finish();
+            void reset();
+
+        private:
+            void transform(const uint8_t *block);
+
+            std::array<uint32_t, 8> state{};
+            std::array<uint8_t, 64> buffer{};
+            std::size_t buffered{0};
+            uint64_t length{0};
+        };
+
+        /**
+         * SHA-256 of a file's content.
+         * @return lowercase hex digest, empty if the file can not be read
+         */
+        std::string sha256File(const std::string &path);
+
+        /**
+         * Digest of a tree of regular files, from the relative path and content digest of
+         * each file. Independent of the order files were found in, archives and
+         * directories with the same files have the same digest.
+         */
+        std::string sha256Tree(const std::map<std::string, std::string> &fileDigests);
+
+    } // namespace Digest
+} // namespace packagemanager
@@ -19,9 +19,16 @@
 
 #pragma once
 
+#include "AppsWatcher.h"
+#include "CatalogSnapshot.h"
 #include "Config.h"
 #include "Debug.h"
 #include "DataStorage.h"
+#include "IoScheduler.h"
+#include "Journal.h"
+#include "LockRegistry.h"
+#include "SingleFlight.h"
+#include "TrashReaper.h"
 
 #include <array>
 #include <atomic>
@@ -29,6 +36,8 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 namespace packagemanager
@@ -39,10 +48,22 @@ namespace packagemanager
         struct StorageDetails;
     }
 
+    // How an install of a version already installed from an identical archive is verified
+    enum class ReinstallCheck
+    {
+        CATALOG, // archive digest recorded in the catalog and the app files present
+        CONTENT  // additionally re-hashes the installed files against the archive
+    };
+
     class Executor
     {
 
         public:
+        Executor() = default;
+        Executor(const Executor &) = delete;
+        Executor &operator=(const Executor &) = delete;
+        ~Executor();
+
         uint32_t Configure(const std::string &configString);
 
         uint32_t Install(const std::string &type,
@@ -50,18 +71,54 @@ namespace packagemanager
                          const std::string &version,
                          const std::string &url,
                          const std::string &appName,
-                         const std::string &category);
+                         const std::string &category,
+                         UsageHint hint = UsageHint::DEFAULT,
+                         ReinstallCheck check = ReinstallCheck::CATALOG,
+                         JobPriority priority = JobPriority::BACKGROUND);
 
         uint32_t Uninstall(const std::string &type,
                            const std::string &id,
                            const std::string &version,
-                           const std::string &uninstallType);
+                           const std::string &uninstallType,
+                           JobPriority priority = JobPriority::BACKGROUND);
+
+        uint32_t Lock(const std::string &id,
+                      const std::string &version);
+
+        uint32_t Unlock(const std::string &id,
+                        const std::string &version);
+
+        /**
+         * Packs app versions not locked for Config::getHibernateAfter() seconds into
+         * compressed archives, Lock unpacks them again.
+         * @param hibernated Out parameter with the number of versions hibernated
+         */
+        uint32_t HibernateIdleApps(unsigned int &hibernated);
+
+        /**
+         * Launches (successful Locks) and how long background installs and
+         * hibernation paused for them since the start.
+         */
+        IoScheduler::Stats GetSchedulerStats() const;
+
+        /**
+         * Dry run of the eviction done before an install of requiredBytes,
+         * plan is empty if no eviction is needed.
+         * @return RETURN_ERROR if not enough space can be freed
+         */
+        uint32_t GetEvictionPlan(unsigned long long requiredBytes,
+                                 UsageHint hint,
+                                 std::vector<DataStorage::EvictionCandidate> &plan);
 
         uint32_t GetStorageDetails(const std::string &type,
                                    const std::string &id,
                                    const std::string &version,
                                    Filesystem::StorageDetails &details);
 
+        // The app list of the current catalog generation, rebuilt only after a write.
+        // Readers of a current snapshot take no lock and run no query.
+        std::shared_ptr<const CatalogSnapshot> GetCatalogSnapshot() const;
+
         uint32_t GetAppDetailsList(const std::string &type,
                                    const std::string &id,
                                    const std::string &version,
@@ -69,8 +126,23 @@ namespace packagemanager
                                    const std::string &category,
                                    std::vector<DataStorage::AppDetails> &appsDetailsList) const;
 
+        // An installed app with its directory and annotations file, see GetInstalledApps
+        struct InstalledAppPaths
+        {
+            DataStorage::AppDetails details;
+            std::string appPath;         // empty if the app volume is unknown
+            std::string annotationsPath; // empty if there is no annotations file
+        };
+
+        // All installed apps with their paths resolved from one catalog query
+        uint32_t GetInstalledApps(std::vector<InstalledAppPaths> &apps) const;
+
         uint32_t GetAppConfigPath(const std::string &path,
                                   std::string &appPath) const;
+        // the app's annotations file, also while it is hibernated
+        uint32_t GetAppAnnotationsPath(const std::string &id,
+                                       const std::string &version,
+                                       std::string &annotationsPath) const;
         uint32_t GetAppInstalledPath(const std::string &id,
                                                const std::string &version, std::string &appPath) const;
             uint32_t GetAppDetails(
@@ -95,12 +167,47 @@ namespace packagemanager
 
     private:
         void handleDirectories();
-        void initializeDataBase(const std::string &dbpath);
+        void startAppsWatcher();
+        void initializeDataBase(const std::string &dbpath, DataStorage::IntegrityCheck check);
+        bool openJournal(std::vector<Journal::Entry> &incomplete, bool &cleanShutdown);
+        void recover(const std::vector<Journal::Entry> &incomplete, bool fullMaintenance);
+        void recoverOperation(const Journal::Entry &entry);
+        void runDeferredStartup(bool fullMaintenance);
+        void waitForBackgroundTasks();
+        const PriorityProfile &profileFor(JobPriority priority) const;
+
+        uint32_t doInstall(const std::string &type,
+                           const std::string &id,
+                           const std::string &version,
+                           const std::string &url,
+                           const std::string &appName,
+                           const std::string &category,
+                           UsageHint hint,
+                           const std::string &digest,
+                           ReinstallCheck check,
+                           JobPriority priority);
+
+        enum class InstalledState
+        {
+            INTACT,     // complete (and has the archive's content)
+            DAMAGED,    // to be replaced by a reinstall
+            UNAVAILABLE // on an app volume that is not mounted, can not be checked
+        };
+
+        InstalledState verifyInstalled(const std::string &id,
+                                       const std::string &version,
+                                       const std::string &url,
+                                       ReinstallCheck check);
 
         bool isAppInstalled(const std::string &type,
                             const std::string &id,
                             const std::string &version);
 
+        DataStorage::AppUsage getAppUsage(const std::string &type,
+                                          const std::string &id,
+                                          const std::string &version,
+                                          const std::string &appPath);
+
         void importAnnotations(const std::string &type,
                                const std::string &id,
                                const std::string &version,
@@ -111,7 +218,30 @@ namespace packagemanager
                        std::string version,
                        std::string url,
                        std::string appName,
-                       std::string category);
+                       std::string category,
+                       UsageHint hint,
+                       const std::string &digest,
+                       JobPriority priority);
+
+        std::vector<const AppVolume *> volumesByPreference(UsageHint hint) const;
+        // bytes missing on the volume for requiredBytes plus reserve, 0 if it fits
+        unsigned long long getShortfall(const AppVolume &volume, unsigned long long requiredBytes, unsigned long long reserve);
+        // Volume for a new install with at least requiredBytes free, nullptr if none fits
+        const AppVolume *chooseVolume(UsageHint hint, unsigned long long requiredBytes);
+        const AppVolume *planEviction(UsageHint hint, unsigned long long requiredBytes,
+                                      std::vector<DataStorage::EvictionCandidate> &plan);
+        bool evict(const DataStorage::EvictionCandidate &candidate);
+        bool hibernate(const DataStorage::HibernationCandidate &candidate);
+        // Unpacks a hibernated version, true if it is extracted (again)
+        bool rehydrate(const std::string &id, const std::string &version);
+        // appspath is always available, other volumes only while mounted
+        bool isVolumeAvailable(const AppVolume &volume) const;
+        std::vector<AppVolume> availableVolumes() const;
+        bool resolveAppPath(const DataStorage::AppLocation &location, std::string &appPath) const;
+        // the annotations file of the app at location, empty if it does not exist
+        std::string annotationsPath(const DataStorage::AppLocation &location, const std::string &id, const std::string &version) const;
+        TrashReaper *reaperFor(const std::string &path) const;
+        void clearTmp();
 
         void doUninstall(std::string type,
                          std::string id,
@@ -120,13 +250,33 @@ namespace packagemanager
 
         void doMaintenance();
 
+        // Recursive owner and mode fix-up, only for trees not extracted by extract()
+        void repairPermissions(const std::string &path);
+
+        // Moves the directory out of the way and lets the reaper delete it
+        void removeInBackground(const std::string &path, const std::string &name);
+
         std::unique_ptr<packagemanager::DataStorage> dataBase;
+        std::vector<std::unique_ptr<TrashReaper>> reapers; // one per app volume, null if not available
+        std::unique_ptr<AppsWatcher> appsWatcher;
+        std::unique_ptr<Journal> journal;
+        std::thread backgroundThread{};
 
         using LockGuard = std::lock_guard<std::mutex>;
 
         std::mutex taskMutex{};
-        typedef std::pair<std::string, std::string> app; // id, version
-        std::vector<app> lockedApps;                     // id, version
+        LockRegistry lockedApps{};
+        IoScheduler scheduler{};
+
+        // type, id, version, sha256 of the archive, app name, category and the options, a call differing
+        // in any of them does not share the result but runs after the install in progress
+        using InstallKey = std::tuple<std::string, std::string, std::string, std::string, std::string, std::string,
+                                      UsageHint, ReinstallCheck, JobPriority>;
+        SingleFlight<InstallKey, uint32_t> installFlights{};
+
+        // published with std::atomic_load / std::atomic_compare_exchange_strong
+        mutable std::shared_ptr<const CatalogSnapshot> snapshot{};
+        mutable SingleFlight<unsigned long long, std::shared_ptr<const CatalogSnapshot>> snapshotFlights{};
 
         Config config{};
     };
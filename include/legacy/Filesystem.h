@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <stdexcept>
 #include <vector>
@@ -44,6 +45,24 @@ namespace packagemanager
             std::string persistentUsedKB{};
         };
 
+        /**
+         * One regular file of an installed app, path is relative to the app directory.
+         * blocks is the allocated size in 512 byte units (st_blocks).
+         */
+        struct FileUsage
+        {
+            std::string path{};
+            unsigned long long size{};
+            unsigned long long blocks{};
+        };
+
+        // Totals of the regular files below a directory, blocks in 512 byte units (st_blocks)
+        struct DirectoryUsage
+        {
+            unsigned long long size{};
+            unsigned long long blocks{};
+        };
+
         const std::string LISA_EPOCH = "0";
 
         bool isAcceptableFilePath(const std::string &pathPart);
@@ -66,7 +85,30 @@ namespace packagemanager
         bool createDirectory(const std::string &path, int gid, bool writeable);
         void removeDirectory(const std::string &path);
         void removeAllDirectoriesExcept(const std::string &path, const std::string &except);
+        void removeAllDirectoriesExcept(const std::string &path, const std::vector<std::string> &except);
+
+        /**
+         * Renames a directory, both paths have to be on the same filesystem.
+         * @return false if the source does not exist
+         */
+        bool moveDirectory(const std::string &from, const std::string &to);
+
+        /**
+         * Atomically moves a fully prepared directory to its final location.
+         * Uses renameat2(RENAME_NOREPLACE) so an existing destination is never replaced.
+         * Throws FilesystemError if the destination exists or the rename fails.
+         */
+        void publishDirectory(const std::string &from, const std::string &to);
+
+        /**
+         * Removes a directory tree with unlinkat() relative to open directory fds.
+         * @param cancel Optional flag checked between entries, removal stops when it is set
+         * @return true if the whole tree was removed
+         */
+        bool removeDirectoryTree(const std::string &path, const std::atomic<bool> *cancel = nullptr);
         std::vector<std::string> getSubdirectories(const std::string &path);
+        // Mode bits given to app files and directories owned by the apps group
+        unsigned int permissionMode(bool isdir, bool writeable);
         void setPermission(const std::string &path, int uid, int gid, bool isdir, bool writeable);
         void setPermissionsRecursively(const std::string &path, int gid, bool writeable);
         bool isEmpty(const std::string &path);
@@ -95,6 +137,10 @@ namespace packagemanager
 
         unsigned long long getFreeSpace(const std::string &path);
         unsigned long long getDirectorySpace(const std::string &path);
+        DirectoryUsage getDirectoryUsage(const std::string &path);
+        std::vector<FileUsage> getDirectoryManifest(const std::string &path);
+        // Digest::sha256Tree of the regular files below path, throws FilesystemError
+        std::string getTreeDigest(const std::string &path);
 
     } // namespace Filesystem
 } // namespace packagemanager
@@ -0,0 +1,108 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <sqlite3.h>
+#include <string>
+
+namespace packagemanager
+{
+
+    /**
+     * A query with N optional "column = ?" filters, an empty value means no filter.
+     * Instead of "(?1 IS NULL OR column = ?1)", which keeps sqlite from using an index
+     * on the column, there is one statement per combination of filters, each naming only
+     * the columns it filters on. All 2^N statements are built up front, the filter on
+     * columns[i] always binds parameter i + 1.
+     */
+    template <std::size_t N>
+    class FilteredQuery
+    {
+        static_assert(N > 0 && N <= 6, "FilteredQuery supports 1 to 6 filters");
+
+    public:
+        using Mask = unsigned int;
+        using Values = std::array<const std::string *, N>;
+
+        /**
+         * @param select the query up to the WHERE clause
+         * @param columns the filtered columns, in the order of the values
+         * @param condition Optional, always part of the WHERE clause
+         */
+        FilteredQuery(const std::string &select, const std::array<const char *, N> &columns, const std::string &condition = {})
+        {
+            for (Mask mask = 0; mask < VARIANTS; ++mask)
+            {
+                std::string where{condition};
+                for (std::size_t i = 0; i < N; ++i)
+                {
+                    if (mask & (1u << i))
+                    {
+                        where += (where.empty() ? "" : " AND ") + std::string{columns[i]} + " = ?" + std::to_string(i + 1);
+                    }
+                }
+                statements[mask] = select + (where.empty() ? "" : " WHERE " + where) + ";";
+            }
+        }
+
+        // the filters of the non-empty values
+        static Mask maskOf(const Values &values)
+        {
+            Mask mask{0};
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                if (!values[i]->empty())
+                {
+                    mask |= 1u << i;
+                }
+            }
+            return mask;
+        }
+
+        const std::string &sql(Mask mask) const
+        {
+            return statements[mask];
+        }
+
+        const std::string &sql(const Values &values) const
+        {
+            return statements[maskOf(values)];
+        }
+
+        // binds the non-empty values to a statement of sql(values)
+        void bind(sqlite3_stmt *stmt, const Values &values) const
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                if (!values[i]->empty())
+                {
+                    sqlite3_bind_text(stmt, static_cast<int>(i + 1), values[i]->c_str(), -1, SQLITE_TRANSIENT);
+                }
+            }
+        }
+
+    private:
+        static constexpr Mask VARIANTS = 1u << N;
+        std::array<std::string, VARIANTS> statements{};
+    };
+
+} // namespace packagemanager
@@ -0,0 +1,84 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace packagemanager
+{
+
+    /**
+     * Two class scheduling of disk heavy work: interactive operations (an app launch)
+     * open a window during which background jobs (installs, hibernation) pause at their
+     * next checkpoint, e.g. between archive entries. A background job pauses for at most
+     * its pause budget in total, so a stream of launches can not starve it.
+     */
+    class IoScheduler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Stats
+        {
+            unsigned long long interactive{0}; // interactive operations noted
+            unsigned long long pauses{0};      // checkpoints at which a background job waited
+            unsigned long long pausedMs{0};    // total time background jobs waited
+        };
+
+        class BackgroundJob
+        {
+        public:
+            explicit BackgroundJob(IoScheduler &scheduler);
+
+            // Blocks while an interactive window is open and the pause budget lasts
+            void checkpoint();
+
+            unsigned long long pauses() const { return jobPauses; }
+            std::chrono::milliseconds paused() const;
+
+        private:
+            IoScheduler &scheduler;
+            Clock::duration pausedTotal{};
+            unsigned long long jobPauses{0};
+        };
+
+        /**
+         * @param interactiveWindow how long background jobs keep pausing after an interactive operation
+         * @param pauseBudget longest total pause of one background job, 0 disables pausing
+         */
+        void configure(std::chrono::milliseconds interactiveWindow, std::chrono::milliseconds pauseBudget);
+
+        // An interactive operation started now, e.g. a successful Lock
+        void noteInteractive();
+
+        Stats getStats() const;
+
+    private:
+        mutable std::mutex mutex{};
+        std::condition_variable condition{};
+        Clock::duration interactiveWindow{};
+        Clock::duration pauseBudget{};
+        Clock::time_point interactiveUntil{};
+        Stats stats{};
+    };
+
+} // namespace packagemanager
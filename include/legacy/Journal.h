@@ -0,0 +1,119 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace packagemanager
+{
+
+    class JournalError : public std::runtime_error
+    {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * Write-ahead intent journal for install and uninstall.
+     * Every operation writes a synced "started" record before touching the
+     * filesystem or the catalog and a "committed" record when both are
+     * consistent again. After a crash only the operations without a
+     * committed record have to be looked at. The file is truncated whenever
+     * no operation is in flight, so it stays tiny.
+     */
+    class Journal
+    {
+    public:
+        enum class Operation
+        {
+            INSTALL,
+            UNINSTALL
+        };
+
+        struct Entry
+        {
+            unsigned long long sequence{};
+            Operation operation{Operation::INSTALL};
+            std::string id{};
+            std::string version{};
+        };
+
+        /**
+         * Begins an operation and commits it when leaving the scope, also if an
+         * exception is thrown. Otherwise the journal stays in flight until the
+         * next start, is never truncated and no clean shutdown is recorded.
+         */
+        class ScopedEntry
+        {
+        public:
+            ScopedEntry(Journal &journal, Operation operation, const std::string &id, const std::string &version);
+
+            ScopedEntry(const ScopedEntry &other) = delete;
+            ScopedEntry &operator=(const ScopedEntry &other) = delete;
+
+            ~ScopedEntry();
+
+        private:
+            Journal &journal;
+            unsigned long long sequence;
+        };
+
+        explicit Journal(const std::string &path);
+
+        Journal(const Journal &) = delete;
+        Journal &operator=(const Journal &) = delete;
+
+        ~Journal();
+
+        /**
+         * Opens the journal and reads back the operations that never committed.
+         * @param cleanShutdown Out parameter, true if the previous run ended with markCleanShutdown()
+         * @return false if there was no journal or it was marked dirty, i.e. the state on disk is unknown
+         */
+        bool open(std::vector<Entry> &incomplete, bool &cleanShutdown);
+
+        unsigned long long begin(Operation operation, const std::string &id, const std::string &version);
+        void commit(unsigned long long sequence);
+
+        // Drops all records, to be called once the incomplete entries were recovered
+        void reset();
+
+        // Next open() reports an unknown state until reset() is called, truncating keeps the mark
+        void markDirty();
+
+        // Recorded only when no operation is in flight
+        void markCleanShutdown();
+
+    private:
+        void append(const std::string &record);
+        void truncate();
+
+        const std::string path;
+        int fd{-1};
+        std::mutex mutex{};
+        unsigned long long lastSequence{0};
+        unsigned int inFlight{0};
+        bool dirty{false};
+    };
+
+} // namespace packagemanager
@@ -0,0 +1,121 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace packagemanager
+{
+
+    struct AppKey
+    {
+        std::string id;
+        std::string version;
+
+        bool operator==(const AppKey &other) const
+        {
+            return id == other.id && version == other.version;
+        }
+    };
+
+    struct AppKeyHash
+    {
+        std::size_t operator()(const AppKey &key) const;
+    };
+
+    /**
+     * Reference counted registry of locked (running) app versions.
+     * Every operation is O(1) and safe to call from concurrent threads.
+     * An uninstall requested while a version is locked is parked here and
+     * handed back once the last lock has been released.
+     */
+    class LockRegistry
+    {
+    public:
+        struct DeferredUninstall
+        {
+            std::string type;
+            std::string uninstallType;
+        };
+
+        // Why new locks of a version are refused
+        enum class BlockReason
+        {
+            NONE,
+            UNINSTALL,
+            REINSTALL,
+            EVICTION,
+            HIBERNATION
+        };
+
+        /**
+         * Takes one lock.
+         * @param blockedBy Optional, set to the reason if the version is blocked, NONE otherwise
+         * @return the number of locks held, 0 if the version is blocked and was not locked
+         */
+        unsigned int lock(const std::string &id, const std::string &version, BlockReason *blockedBy = nullptr);
+
+        /**
+         * Releases one lock.
+         * @param remaining Out parameter with the number of locks still held
+         * @return false if the version was not locked
+         */
+        bool unlock(const std::string &id, const std::string &version, unsigned int &remaining);
+
+        bool isLocked(const std::string &id, const std::string &version) const;
+
+        /**
+         * Parks the uninstall if the version is currently locked, otherwise blocks new
+         * locks in the same step. The caller then removes the version and calls unblock().
+         * @return true if the uninstall was deferred, false if the version is blocked
+         */
+        bool deferUninstallOrBlock(const std::string &id, const std::string &version, const DeferredUninstall &uninstall);
+
+        /**
+         * Hands out the parked uninstall, but only once the version is no longer locked.
+         * The version is blocked like by deferUninstallOrBlock() until unblock().
+         * @return true if there was a deferred uninstall to run
+         */
+        bool takeDeferredUninstall(const std::string &id, const std::string &version, DeferredUninstall &uninstall);
+
+        /**
+         * Blocks new locks of an unlocked version while it is being removed.
+         * @return false if the version is locked
+         */
+        bool blockIfUnlocked(const std::string &id, const std::string &version, BlockReason reason);
+        void unblock(const std::string &id, const std::string &version);
+
+    private:
+        struct Entry
+        {
+            unsigned int count{0};
+            bool uninstallPending{false};
+            BlockReason blockedBy{BlockReason::NONE};
+            DeferredUninstall uninstall{};
+        };
+
+        mutable std::mutex mutex{};
+        std::unordered_map<AppKey, Entry, AppKeyHash> entries{};
+    };
+
+} // namespace packagemanager
@@ -34,13 +34,27 @@ namespace packagemanager
 
         Result Install(const std::string &packageId, const std::string &version, const NameValues &additionalMetadata, const std::string &fileLocator, ConfigMetaData &configMetadata) override;
         Result Lock(const std::string &packageId, const std::string &version, std::string &unpackedPath, ConfigMetaData &configMetadata, NameValues &additionalLocks) override;
+        Result Unlock(const std::string &packageId, const std::string &version) override;
         Result GetFileMetadata(const std::string &fileLocator, std::string &packageId, std::string &version, ConfigMetaData &configMetadata) override;
 
         Result Uninstall(const std::string &packageId) override;
 
+        /**
+         * Hibernates the app versions unused for "hibernateAfterSeconds", meant to be called
+         * periodically while the device is idle. Lock rehydrates them transparently.
+         */
+        Result HibernateIdleApps();
+
+        /**
+         * Lists the (packageId, version) pairs an install of requiredBytes would evict,
+         * without removing anything. FAILED if the space can not be made available.
+         */
+        Result GetEvictionPlan(unsigned long long requiredBytes, const std::string &usageHint, NameValues &versions);
+
     private:
         packagemanager::Executor executor;
         bool populateConfigValues(const std::string &packageId, const std::string &version, ConfigMetaData &configMetadata /* out*/);
+        bool populateConfigValues(const std::string &unpackedPath, const std::string &configPath, ConfigMetaData &configMetadata /* out*/, const std::string &packageId);
 
     };
 
@@ -0,0 +1,98 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+
+namespace packagemanager
+{
+
+    /**
+     * Coalesces concurrent calls with the same key: the first caller (the leader) runs
+     * the work, callers arriving while it runs wait for and share its result, or its
+     * exception. A call after the leader finished starts a new flight.
+     */
+    template <typename Key, typename Result>
+    class SingleFlight
+    {
+    public:
+        /**
+         * @param shared Optional, set to true if the result of another caller's work was returned
+         */
+        Result run(const Key &key, const std::function<Result()> &work, bool *shared = nullptr)
+        {
+            std::promise<Result> promise;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto it = flights.find(key);
+                if (it != flights.end())
+                {
+                    auto future = it->second;
+                    lock.unlock();
+                    if (shared)
+                    {
+                        *shared = true;
+                    }
+                    return future.get();
+                }
+                flights.emplace(key, promise.get_future().share());
+            }
+            if (shared)
+            {
+                *shared = false;
+            }
+
+            try
+            {
+                Result result = work();
+                land(key);
+                promise.set_value(result);
+                return result;
+            }
+            catch (...)
+            {
+                land(key);
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        bool inFlight(const Key &key) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return flights.count(key) != 0;
+        }
+
+    private:
+        void land(const Key &key)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            flights.erase(key);
+        }
+
+        mutable std::mutex mutex{};
+        std::map<Key, std::shared_future<Result>> flights{};
+    };
+
+} // namespace packagemanager
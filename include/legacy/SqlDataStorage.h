@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include "Config.h"
+#include "ConnectionPool.h"
 #include "DataStorage.h"
 
 #include <string>
@@ -35,14 +37,22 @@ namespace packagemanager
     class SqlDataStorage : public DataStorage
     {
     public:
-        explicit SqlDataStorage(const std::string &path) : db_path(path + db_name) {}
+        explicit SqlDataStorage(const std::string &path, const DatabaseProfile &profile = {}) : db_path(path + db_name), profile(profile) {}
         SqlDataStorage(const SqlDataStorage &) = delete;
         SqlDataStorage &operator=(const SqlDataStorage &) = delete;
         ~SqlDataStorage();
 
-        void Initialize() override;
+        void Initialize(IntegrityCheck check) override;
+        std::unique_ptr<Transaction> BeginTransaction() override;
+        bool CheckIntegrity() override;
+        bool WasCreated() const override;
+        unsigned long long GetGeneration() const override { return connections.generation(); }
         std::vector<std::string> GetAppsPaths(const std::string &type, const std::string &id, const std::string &version) override;
 
+        std::vector<AppLocation> GetAppsLocations(const std::string &type, const std::string &id, const std::string &version) override;
+
+        std::vector<InstalledApp> GetInstalledApps() override;
+
         std::vector<std::string> GetDataPaths(const std::string &type, const std::string &id) override;
 
         std::vector<DataStorage::AppDetails> GetAppDetailsList(const std::string &type, const std::string &id, const std::string &version,
@@ -50,6 +60,8 @@ namespace packagemanager
 
         std::vector<DataStorage::AppDetails> GetAppDetailsListOuterJoin(const std::string &type, const std::string &id, const std::string &version,
                                                                         const std::string &appName, const std::string &category) override;
+        void VisitAppDetails(const AppDetailsVisitor &visitor, bool outerJoin, const std::string &type, const std::string &id,
+                             const std::string &version, const std::string &appName, const std::string &category) override;
         void AddInstalledApp(const std::string &type,
                              const std::string &id,
                              const std::string &version,
@@ -57,7 +69,8 @@ namespace packagemanager
                              const std::string &appName,
                              const std::string &category,
                              const std::string &appPath,
-                             const std::string &appStoragePath) override;
+                             const std::string &appStoragePath,
+                             const std::string &volume = {}) override;
 
         bool IsAppInstalled(const std::string &type,
                             const std::string &id,
@@ -82,6 +95,11 @@ namespace packagemanager
                          const std::string &key,
                          const std::string &value) override;
 
+        void SetMetadata(const std::string &type,
+                         const std::string &id,
+                         const std::string &version,
+                         const MetadataValues &values) override;
+
         void ClearMetadata(const std::string &type,
                            const std::string &id,
                            const std::string &version,
@@ -91,21 +109,68 @@ namespace packagemanager
                                              const std::string &id,
                                              const std::string &version) override;
 
+        void SetAppUsage(const std::string &type,
+                         const std::string &id,
+                         const std::string &version,
+                         const std::vector<Filesystem::FileUsage> &manifest) override;
+
+        bool GetAppUsage(const std::string &type,
+                         const std::string &id,
+                         const std::string &version,
+                         AppUsage &usage) override;
+
+        AppUsage GetTotalUsage() override;
+        AppUsage GetVolumeUsage(const std::string &volume) override;
+
+        void SetLastLocked(const std::string &id,
+                           const std::string &version,
+                           long long timestamp) override;
+
+        std::vector<EvictionCandidate> GetEvictionCandidates(const std::string &volume) override;
+
+        void SetHibernated(const std::string &id,
+                           const std::string &version,
+                           bool hibernated) override;
+
+        void SetRehydrationTime(const std::string &id,
+                                const std::string &version,
+                                long long milliseconds) override;
+
+        void SetArchiveDigest(const std::string &id,
+                              const std::string &version,
+                              const std::string &digest) override;
+
+        std::string GetArchiveDigest(const std::string &id,
+                                     const std::string &version) override;
+
+        std::vector<HibernationCandidate> GetHibernationCandidates(long long lockedBefore) override;
+
     private:
-        static sqlite3 *sqlite;
         const std::string db_name = "apps.db";
         const std::string db_path;
+        const DatabaseProfile profile;
+        // the writer and, in WAL mode, read-only connections for concurrent readers
+        mutable ConnectionPool connections;
+        bool created{false};
         using SqlCallback = int (*)(void *, int, char **, char **);
         constexpr static int INVALID_INDEX = -1;
+        constexpr static int SCHEMA_VERSION = 5;
 
         void Terminate();
-        void InitDB();
+        void InitDB(IntegrityCheck check);
         void OpenConnection();
+        void ApplyProfile() const;
+        // per connection pragmas, also run on every reader
+        std::string ConnectionPragmas() const;
         void CreateTables() const;
+        void MigrateTables() const;
+        int GetSchemaVersion() const;
         void EnableForeignKeys() const;
         void ExecuteCommand(const std::string &command, SqlCallback callback = nullptr, void *val = nullptr) const;
-        void Validate() const;
+        void Validate(IntegrityCheck check) const;
+        bool TableExists(const std::string &table) const;
         std::vector<std::string> GetPaths(sqlite3_stmt *stmt) const;
+        AppUsage GetUsageSum(sqlite3_stmt *stmt) const;
 
         void InsertIntoApps(const std::string &type,
                             const std::string &id,
@@ -121,6 +186,7 @@ namespace packagemanager
                                      const std::string &category,
                                      const std::string &url,
                                      const std::string &appPath,
+                                     const std::string &volume,
                                      const std::string &timeCreated);
 
         void DeleteFromInstalledApps(const std::string &type,
@@ -130,6 +196,14 @@ namespace packagemanager
         void DeleteFromApps(const std::string &type,
                             const std::string &id);
 
+        int GetInstalledAppIdx(const std::string &type,
+                               const std::string &id,
+                               const std::string &version);
+
+        void DeleteFromAppFiles(const std::string &type,
+                                const std::string &id,
+                                const std::string &version);
+
         void ExecuteSqlStep(sqlite3_stmt *stmt);
     };
 
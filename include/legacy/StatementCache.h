@@ -0,0 +1,85 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+
+namespace packagemanager
+{
+
+    /**
+     * Prepared statements of one connection, keyed by their SQL text. A statement
+     * is prepared on first use and kept until the connection is closed, later uses
+     * only reset it and clear its bindings.
+     * A statement is handed to one caller at a time, concurrent callers of the same
+     * query get a statement of their own which is finalized on release.
+     */
+    class StatementCache
+    {
+    public:
+        // Statement acquired for the scope, converts to sqlite3_stmt * for the sqlite3 calls
+        class Statement
+        {
+        public:
+            Statement(StatementCache &cache, const std::string &query) : cache(cache), stmt(cache.acquire(query)) {}
+            Statement(const Statement &) = delete;
+            Statement &operator=(const Statement &) = delete;
+            ~Statement() { cache.release(stmt); }
+
+            operator sqlite3_stmt *() const { return stmt; }
+
+        private:
+            StatementCache &cache;
+            sqlite3_stmt *stmt;
+        };
+
+        StatementCache() = default;
+        StatementCache(const StatementCache &) = delete;
+        StatementCache &operator=(const StatementCache &) = delete;
+        ~StatementCache();
+
+        // Finalizes all statements, later ones are prepared on connection
+        void reset(sqlite3 *connection);
+
+        // throws DataStorageError if the query does not compile
+        sqlite3_stmt *acquire(const std::string &query);
+        void release(sqlite3_stmt *stmt);
+
+        std::size_t size() const;
+
+    private:
+        struct Entry
+        {
+            sqlite3_stmt *stmt{nullptr};
+            bool inUse{false};
+        };
+
+        void finalizeAll();
+
+        mutable std::mutex mutex{};
+        sqlite3 *connection{nullptr};
+        std::unordered_map<std::string, Entry> statements{};
+    };
+
+} // namespace packagemanager
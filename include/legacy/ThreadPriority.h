@@ -0,0 +1,59 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Config.h"
+
+namespace packagemanager
+{
+
+    namespace ThreadPriority
+    {
+        /**
+         * Applies the io class and nice value of the profile to the calling thread only.
+         * @return false if the kernel refused a part of it, the rest is still applied
+         */
+        bool apply(const PriorityProfile &profile);
+    } // namespace ThreadPriority
+
+    /**
+     * Applies a priority profile to the calling thread for the lifetime of the object
+     * and restores the previous io priority and nice value afterwards. Nothing is
+     * changed for a disabled profile. The nice value is left alone if the thread
+     * could not lower it back (no CAP_SYS_NICE and RLIMIT_NICE too low).
+     */
+    class ScopedThreadPriority
+    {
+    public:
+        explicit ScopedThreadPriority(const PriorityProfile &profile);
+
+        ScopedThreadPriority(const ScopedThreadPriority &) = delete;
+        ScopedThreadPriority &operator=(const ScopedThreadPriority &) = delete;
+
+        ~ScopedThreadPriority();
+
+    private:
+        bool applied{false};
+        bool niced{false};
+        int previousIoPriority{0};
+        int previousNice{0};
+    };
+
+} // namespace packagemanager
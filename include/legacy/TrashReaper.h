@@ -0,0 +1,71 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace packagemanager
+{
+
+    /**
+     * Background deleter for the trash directory.
+     * Uninstall only renames app directories into the trash, this low priority
+     * thread unlinks their content afterwards. Anything left in the trash
+     * (e.g. after a reboot) is picked up again when the reaper is started.
+     */
+    class TrashReaper
+    {
+    public:
+        explicit TrashReaper(const std::string &trashPath);
+
+        TrashReaper(const TrashReaper &) = delete;
+        TrashReaper &operator=(const TrashReaper &) = delete;
+
+        ~TrashReaper();
+
+        void start();
+        void wakeUp();
+
+        // Unique path inside the trash for a directory that is about to be removed
+        std::string createTrashPath(const std::string &name);
+
+        // Blocks until the reaper has nothing left to do
+        void waitUntilIdle();
+
+    private:
+        void run();
+        bool reap();
+
+        const std::string trashPath;
+        std::thread thread{};
+        std::mutex mutex{};
+        std::condition_variable condition{};
+        std::condition_variable emptyCondition{};
+        bool workPending{false};
+        bool idle{true};
+        std::atomic<bool> stopRequested{false};
+        unsigned long long trashCounter{0};
+    };
+
+} // namespace packagemanager
@@ -0,0 +1,70 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+#include <sys/stat.h>
+
+namespace packagemanager
+{
+    namespace Filesystem
+    {
+
+        /**
+         * Walks a directory tree reading every directory once and stat'ing every entry at most once.
+         * Directory entries are classified by d_type, only non-directories (and entries of unknown
+         * type) are fstatat()'ed relative to the open parent directory. Subdirectories are handed
+         * out to up to 'threads' threads, the calling thread included.
+         */
+        class TreeWalker
+        {
+        public:
+            struct Entry
+            {
+                int dirFd;                      // open parent directory, valid during the visit only
+                const char *name;               // name within the parent
+                const std::string &parentPath;  // parent relative to the root, empty or ending with '/'
+                bool isDirectory;
+                const struct stat &st;          // only st_mode is set for directories
+            };
+
+            // Called from several threads at once, must not throw
+            using Visitor = std::function<void(const Entry &entry)>;
+
+            explicit TreeWalker(unsigned int threads = defaultThreads());
+
+            /**
+             * Visits every entry below root, directories before their content.
+             * @param cancel Optional flag checked between entries, the walk stops when it is set
+             * @return false if the walk was cancelled or any directory could not be read
+             */
+            bool walk(const std::string &root, const Visitor &visitor, const std::atomic<bool> *cancel = nullptr) const;
+
+            static unsigned int defaultThreads();
+
+        private:
+            unsigned int threads;
+        };
+
+    } // namespace Filesystem
+} // namespace packagemanager
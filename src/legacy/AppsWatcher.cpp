@@ -0,0 +1,216 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AppsWatcher.h"
+#include "Debug.h"
+#include "Filesystem.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace packagemanager
+{
+
+    namespace
+    { // anonymous
+
+        // only directories are of interest, both levels are created and removed as a whole
+        constexpr uint32_t WATCH_MASK = IN_ONLYDIR | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+    } // namespace anonymous
+
+    AppsWatcher::AppsWatcher(const std::string &appsRoot)
+        : appsRoot(appsRoot)
+    {
+    }
+
+    AppsWatcher::~AppsWatcher()
+    {
+        if (inotifyFd >= 0)
+        {
+            close(inotifyFd);
+        }
+    }
+
+    bool AppsWatcher::start()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0)
+        {
+            ERROR("[AppsWatcher::start] inotify_init1 failed: ", strerror(errno));
+            return false;
+        }
+
+        rootWatch = inotify_add_watch(inotifyFd, appsRoot.c_str(), WATCH_MASK);
+        if (rootWatch < 0)
+        {
+            ERROR("[AppsWatcher::start] Unable to watch ", appsRoot, ": ", strerror(errno));
+            close(inotifyFd);
+            inotifyFd = -1;
+            return false;
+        }
+
+        rescan();
+        INFO("[AppsWatcher::start] Watching ", appsRoot, ", ", apps.size(), " ids found");
+        return true;
+    }
+
+    AppsWatcher::AppDirectories AppsWatcher::getAppDirectories()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drainEvents();
+        if (overflowed)
+        {
+            WARNING("[AppsWatcher::getAppDirectories] inotify queue overflowed, rescanning ", appsRoot);
+            rescan();
+        }
+        return apps;
+    }
+
+    void AppsWatcher::drainEvents()
+    {
+        alignas(struct inotify_event) char buffer[16 * 1024];
+        while (true)
+        {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+            {
+                if (length < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                break;
+            }
+
+            for (char *ptr = buffer; ptr < buffer + length;)
+            {
+                auto *event = reinterpret_cast<struct inotify_event *>(ptr);
+                ptr += sizeof(struct inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    overflowed = true;
+                    continue;
+                }
+                if (!(event->mask & IN_ISDIR) || event->len == 0)
+                {
+                    continue;
+                }
+
+                std::string name{event->name};
+                bool added = event->mask & (IN_CREATE | IN_MOVED_TO);
+                bool removed = event->mask & (IN_DELETE | IN_MOVED_FROM);
+                if (event->wd == rootWatch)
+                {
+                    if (added)
+                    {
+                        watchId(name);
+                    }
+                    else if (removed)
+                    {
+                        unwatchId(name);
+                    }
+                    continue;
+                }
+
+                auto it = watchedIds.find(event->wd);
+                if (it == watchedIds.end())
+                {
+                    continue;
+                }
+                if (added)
+                {
+                    apps[it->second].insert(name);
+                }
+                else if (removed)
+                {
+                    apps[it->second].erase(name);
+                }
+            }
+        }
+    }
+
+    void AppsWatcher::rescan()
+    {
+        for (const auto &watch : idWatches)
+        {
+            inotify_rm_watch(inotifyFd, watch.second);
+        }
+        watchedIds.clear();
+        idWatches.clear();
+        apps.clear();
+        overflowed = false;
+
+        for (const auto &id : Filesystem::getSubdirectories(appsRoot))
+        {
+            watchId(id);
+        }
+    }
+
+    void AppsWatcher::watchId(const std::string &id)
+    {
+        std::string idPath = appsRoot + id;
+        int watch = inotify_add_watch(inotifyFd, idPath.c_str(), WATCH_MASK);
+        if (watch < 0)
+        {
+            // removed again before the event was handled, its delete event follows
+            if (errno != ENOENT)
+            {
+                ERROR("[AppsWatcher::watchId] Unable to watch ", idPath, ": ", strerror(errno));
+                overflowed = true;
+            }
+            return;
+        }
+        watchedIds[watch] = id;
+        idWatches[id] = watch;
+
+        // versions created before the watch was in place do not produce events
+        auto &versions = apps[id];
+        try
+        {
+            for (const auto &version : Filesystem::getSubdirectories(idPath))
+            {
+                versions.insert(version);
+            }
+        }
+        catch (Filesystem::FilesystemError &error)
+        {
+            // removed meanwhile, handled with its delete event
+            DEBUG("[AppsWatcher::watchId] ", error.what());
+        }
+    }
+
+    void AppsWatcher::unwatchId(const std::string &id)
+    {
+        auto it = idWatches.find(id);
+        if (it != idWatches.end())
+        {
+            // a directory moved away (to the trash) keeps its watch
+            inotify_rm_watch(inotifyFd, it->second);
+            watchedIds.erase(it->second);
+            idWatches.erase(it);
+        }
+        apps.erase(id);
+    }
+
+} // namespace packagemanager
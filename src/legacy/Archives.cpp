@@ -20,11 +20,18 @@
 
 #include "Archives.h"
 #include "Debug.h"
+#include "Digest.h"
 
 #include <archive.h>
 #include <archive_entry.h>
 
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
 #include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace packagemanager
 {
@@ -33,12 +40,18 @@ namespace packagemanager
         static constexpr int BLOCK_SIZE = 10240;
         static constexpr int ARCHIVE_FLAGS = ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_PERM | ARCHIVE_EXTRACT_ACL | ARCHIVE_EXTRACT_FFLAGS;
 
-        int unpackArchive(const std::string &archivePath, const std::string &destinationPath)
+        int unpackArchive(const std::string &archivePath, const std::string &destinationPath,
+                          std::vector<Filesystem::FileUsage> *manifest, const Ownership *ownership,
+                          const std::function<void()> &betweenEntries)
         {
+            // with an ownership libarchive applies it with fchown/fchmod on the fd it creates the entry with
+            const int flags = ownership ? ARCHIVE_FLAGS | ARCHIVE_EXTRACT_OWNER : ARCHIVE_FLAGS;
+
             int result = 0;
             struct archive *theArchive = archive_read_new();
             archive_read_support_format_tar(theArchive);
             archive_read_support_filter_gzip(theArchive);
+            archive_read_support_filter_zstd(theArchive);
 
             // Read the archive
             if (archive_read_open_filename(theArchive, archivePath.c_str(), BLOCK_SIZE) != ARCHIVE_OK)
@@ -50,8 +63,15 @@ namespace packagemanager
 
             // Extract the contents
             struct archive_entry *entry{};
+            bool first{true};
             while (true)
             {
+                if (betweenEntries && !first)
+                {
+                    betweenEntries();
+                }
+                first = false;
+
                 auto readHeaderResult = archive_read_next_header(theArchive, &entry);
 
                 if (readHeaderResult == ARCHIVE_EOF)
@@ -69,7 +89,8 @@ namespace packagemanager
                     WARNING("Warning while reading entry ", archive_error_string(theArchive));
                 }
 
-                std::string destPath{destinationPath + archive_entry_pathname(entry)};
+                std::string entryPath{archive_entry_pathname(entry)};
+                std::string destPath{destinationPath + entryPath};
                 archive_entry_set_pathname(entry, destPath.c_str());
 
                 const char *origHardlink = archive_entry_hardlink(entry);
@@ -79,7 +100,21 @@ namespace packagemanager
                     archive_entry_set_hardlink(entry, destPathHardLink.c_str());
                 }
 
-                auto extractStatus = archive_read_extract(theArchive, entry, ARCHIVE_FLAGS);
+                if (ownership)
+                {
+                    // names take precedence over ids when extracting, drop them
+                    archive_entry_set_uname(entry, nullptr);
+                    archive_entry_set_gname(entry, nullptr);
+                    archive_entry_set_uid(entry, ownership->uid);
+                    archive_entry_set_gid(entry, ownership->gid);
+                    if (archive_entry_filetype(entry) != AE_IFLNK)
+                    {
+                        bool isDir = archive_entry_filetype(entry) == AE_IFDIR;
+                        archive_entry_set_perm(entry, Filesystem::permissionMode(isDir, ownership->writeable));
+                    }
+                }
+
+                auto extractStatus = archive_read_extract(theArchive, entry, flags);
                 if (extractStatus == ARCHIVE_OK || extractStatus == ARCHIVE_WARN)
                 {
                     DEBUG("extracted: %s", archive_entry_pathname(entry));
@@ -87,6 +122,14 @@ namespace packagemanager
                     {
                         WARNING("Warning while extracting ", archive_error_string(theArchive));
                     }
+
+                    struct stat st{};
+                    if (manifest && lstat(destPath.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+                    {
+                        manifest->push_back(Filesystem::FileUsage{entryPath,
+                                                                  static_cast<unsigned long long>(st.st_size),
+                                                                  static_cast<unsigned long long>(st.st_blocks)});
+                    }
                 }
                 else
                 {
@@ -99,5 +142,231 @@ namespace packagemanager
             return result;
         }
 
+        namespace
+        {
+            bool copyFileData(struct archive *theArchive, const char *sourcePath)
+            {
+                int fd = open(sourcePath, O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                {
+                    ERROR("Unable to open ", sourcePath);
+                    return false;
+                }
+                char buffer[BLOCK_SIZE * 8];
+                ssize_t bytesRead;
+                bool ok{true};
+                while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+                {
+                    if (archive_write_data(theArchive, buffer, bytesRead) != bytesRead)
+                    {
+                        ERROR("Error while writing ", sourcePath, ": ", archive_error_string(theArchive));
+                        ok = false;
+                        break;
+                    }
+                }
+                ok = ok && bytesRead == 0;
+                close(fd);
+                return ok;
+            }
+        } // namespace
+
+        int packArchive(const std::string &sourceDir, const std::string &archivePath, int compressionLevel,
+                        const std::function<void()> &betweenEntries)
+        {
+            std::string root{sourceDir};
+            while (root.size() > 1 && root.back() == '/')
+            {
+                root.pop_back();
+            }
+
+            struct archive *disk = archive_read_disk_new();
+            archive_read_disk_set_symlink_physical(disk);
+            archive_read_disk_set_standard_lookup(disk);
+
+            struct archive *theArchive = archive_write_new();
+            archive_write_set_format_pax_restricted(theArchive);
+            archive_write_add_filter_zstd(theArchive);
+            archive_write_set_filter_option(theArchive, "zstd", "compression-level", std::to_string(compressionLevel).c_str());
+
+            int result = 0;
+            if (archive_read_disk_open(disk, root.c_str()) != ARCHIVE_OK)
+            {
+                ERROR("Failed to open ", root, ": ", archive_error_string(disk));
+            }
+            else if (archive_write_open_filename(theArchive, archivePath.c_str()) != ARCHIVE_OK)
+            {
+                ERROR("Failed to create archive: ", archive_error_string(theArchive));
+            }
+            else
+            {
+                struct archive_entry *entry = archive_entry_new();
+                bool first{true};
+                while (true)
+                {
+                    if (betweenEntries && !first)
+                    {
+                        betweenEntries();
+                    }
+                    first = false;
+
+                    auto readHeaderResult = archive_read_next_header2(disk, entry);
+                    if (readHeaderResult == ARCHIVE_EOF)
+                    {
+                        result = 1;
+                        break;
+                    }
+                    if (readHeaderResult != ARCHIVE_OK && readHeaderResult != ARCHIVE_WARN)
+                    {
+                        ERROR("error while reading ", root, ": ", archive_error_string(disk));
+                        break;
+                    }
+                    archive_read_disk_descend(disk);
+
+                    std::string entryPath{archive_entry_pathname(entry)};
+                    if (entryPath.size() <= root.size() + 1)
+                    {
+                        // the root itself, its owner and mode belong to the destination
+                        archive_entry_clear(entry);
+                        continue;
+                    }
+                    archive_entry_set_pathname(entry, entryPath.substr(root.size() + 1).c_str());
+
+                    if (archive_write_header(theArchive, entry) != ARCHIVE_OK)
+                    {
+                        ERROR("Error while writing header of ", entryPath, ": ", archive_error_string(theArchive));
+                        break;
+                    }
+                    if (archive_entry_filetype(entry) == AE_IFREG && archive_entry_size(entry) > 0 &&
+                        !copyFileData(theArchive, archive_entry_sourcepath(entry)))
+                    {
+                        break;
+                    }
+                    archive_entry_clear(entry);
+                }
+                archive_entry_free(entry);
+            }
+
+            if (archive_write_close(theArchive) != ARCHIVE_OK)
+            {
+                ERROR("Error while closing archive: ", archive_error_string(theArchive));
+                result = 0;
+            }
+            archive_write_free(theArchive);
+            archive_read_close(disk);
+            archive_read_free(disk);
+
+            if (result)
+            {
+                int fd = open(archivePath.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0 || fsync(fd) != 0)
+                {
+                    ERROR("Unable to sync ", archivePath);
+                    result = 0;
+                }
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+            return result;
+        }
+
+        std::string getContentDigest(const std::string &archivePath)
+        {
+            struct archive *theArchive = archive_read_new();
+            archive_read_support_format_tar(theArchive);
+            archive_read_support_filter_gzip(theArchive);
+            archive_read_support_filter_zstd(theArchive);
+
+            std::map<std::string, std::string> fileDigests;
+            bool ok{false};
+            if (archive_read_open_filename(theArchive, archivePath.c_str(), BLOCK_SIZE) != ARCHIVE_OK)
+            {
+                ERROR("Failed to open archive: ", archive_error_string(theArchive));
+            }
+            else
+            {
+                struct archive_entry *entry{};
+                int readHeaderResult;
+                while ((readHeaderResult = archive_read_next_header(theArchive, &entry)) == ARCHIVE_OK || readHeaderResult == ARCHIVE_WARN)
+                {
+                    std::string entryPath{archive_entry_pathname(entry)};
+                    while (entryPath.compare(0, 2, "./") == 0)
+                    {
+                        entryPath.erase(0, 2);
+                    }
+                    const char *hardlink = archive_entry_hardlink(entry);
+                    if (hardlink)
+                    {
+                        // same content as the earlier entry it links to
+                        std::string target{hardlink};
+                        while (target.compare(0, 2, "./") == 0)
+                        {
+                            target.erase(0, 2);
+                        }
+                        auto it = fileDigests.find(target);
+                        if (it != fileDigests.end())
+                        {
+                            fileDigests[entryPath] = it->second;
+                        }
+                        continue;
+                    }
+                    if (archive_entry_filetype(entry) != AE_IFREG)
+                    {
+                        continue;
+                    }
+                    Digest::Sha256 sha;
+                    const void *block;
+                    size_t size;
+                    int64_t offset;
+                    int readResult;
+                    while ((readResult = archive_read_data_block(theArchive, &block, &size, &offset)) == ARCHIVE_OK)
+                    {
+                        sha.update(block, size);
+                    }
+                    if (readResult != ARCHIVE_EOF)
+                    {
+                        ERROR("Error while reading ", entryPath, ": ", archive_error_string(theArchive));
+                        break;
+                    }
+                    fileDigests[entryPath] = sha.finish();
+                }
+                ok = readHeaderResult == ARCHIVE_EOF;
+            }
+            archive_read_close(theArchive);
+            archive_read_free(theArchive);
+            return ok ? Digest::sha256Tree(fileDigests) : std::string{};
+        }
+
+        unsigned long long getUnpackedSizeEstimate(const std::string &archivePath)
+        {
+            std::ifstream file(archivePath, std::ios::binary | std::ios::ate);
+            if (!file)
+            {
+                return 0;
+            }
+            auto fileSize = static_cast<unsigned long long>(file.tellg());
+
+            unsigned char header[2]{};
+            unsigned char trailer[4]{};
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(header), sizeof(header));
+            bool isGzip = file && header[0] == 0x1f && header[1] == 0x8b;
+            if (!isGzip || fileSize < 18)
+            {
+                return fileSize;
+            }
+
+            // ISIZE, little endian, last 4 bytes of the (last) gzip member
+            file.seekg(-4, std::ios::end);
+            file.read(reinterpret_cast<char *>(trailer), sizeof(trailer));
+            if (!file)
+            {
+                return fileSize;
+            }
+            unsigned long long unpacked = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<unsigned long long>(trailer[3]) << 24);
+            return std::max(unpacked, fileSize);
+        }
+
     } // namespace Archive
 } // namespace packagemanager
\ No newline at end of file
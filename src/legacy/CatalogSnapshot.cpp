@@ -0,0 +1,123 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CatalogSnapshot.h"
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace packagemanager
+{
+
+    namespace
+    {
+        DataStorage::TextView view(const std::string &text)
+        {
+            return DataStorage::TextView{text.data(), text.size()};
+        }
+    }
+
+    constexpr std::size_t CatalogSnapshot::npos;
+
+    std::size_t CatalogSnapshot::TextHash::operator()(const DataStorage::TextView &text) const
+    {
+        return std::hash<std::string_view>{}(std::string_view{text.data, text.size});
+    }
+
+    std::size_t CatalogSnapshot::TextHash::operator()(const Key &key) const
+    {
+        return (*this)(key.first) * 31 + (*this)(key.second);
+    }
+
+    bool CatalogSnapshot::TextEqual::operator()(const DataStorage::TextView &a, const DataStorage::TextView &b) const
+    {
+        return a.size == b.size && std::memcmp(a.data, b.data, a.size) == 0;
+    }
+
+    bool CatalogSnapshot::TextEqual::operator()(const Key &a, const Key &b) const
+    {
+        return (*this)(a.first, b.first) && (*this)(a.second, b.second);
+    }
+
+    std::shared_ptr<const CatalogSnapshot> CatalogSnapshot::build(DataStorage &storage)
+    {
+        std::shared_ptr<CatalogSnapshot> snapshot{new CatalogSnapshot};
+        snapshot->catalogGeneration = storage.GetGeneration();
+
+        // only the arena offsets are kept while building, it is reallocated as it grows
+        std::unordered_map<std::string, Span> interned;
+        auto intern = [&snapshot, &interned](const DataStorage::TextView &text)
+        {
+            auto inserted = interned.emplace(text.str(), Span{});
+            if (inserted.second)
+            {
+                inserted.first->second = Span{static_cast<std::uint32_t>(snapshot->arena.size()), static_cast<std::uint32_t>(text.size)};
+                snapshot->arena.append(text.data, text.size);
+            }
+            return inserted.first->second;
+        };
+
+        storage.VisitAppDetails([&snapshot, &intern](const DataStorage::AppDetailsView &row)
+        {
+            snapshot->rows.push_back(Row{intern(row.type), intern(row.id), intern(row.version),
+                                         intern(row.appName), intern(row.category), intern(row.url),
+                                         intern(row.volume), intern(row.path), row.hibernated});
+            return true;
+        }, true);
+        snapshot->arena.shrink_to_fit();
+        snapshot->rows.shrink_to_fit();
+
+        snapshot->byId.reserve(snapshot->rows.size());
+        snapshot->byIdVersion.reserve(snapshot->rows.size());
+        for (std::size_t row = 0; row < snapshot->rows.size(); ++row)
+        {
+            const auto &spans = snapshot->rows[row];
+            auto id = snapshot->text(spans.id);
+            snapshot->byId.emplace(id, row);
+            // the outer join row of an app without installed version has none
+            if (spans.version.size)
+            {
+                snapshot->byIdVersion.emplace(Key{id, snapshot->text(spans.version)}, row);
+            }
+        }
+        return snapshot;
+    }
+
+    DataStorage::AppDetailsView CatalogSnapshot::operator[](std::size_t row) const
+    {
+        const auto &spans = rows[row];
+        return DataStorage::AppDetailsView{text(spans.type), text(spans.id), text(spans.version),
+                                           text(spans.appName), text(spans.category), text(spans.url),
+                                           text(spans.volume), text(spans.path), spans.hibernated};
+    }
+
+    std::size_t CatalogSnapshot::find(const std::string &id) const
+    {
+        auto it = byId.find(view(id));
+        return it != byId.end() ? it->second : npos;
+    }
+
+    std::size_t CatalogSnapshot::find(const std::string &id, const std::string &version) const
+    {
+        auto it = byIdVersion.find(Key{view(id), view(version)});
+        return it != byIdVersion.end() ? it->second : npos;
+    }
+
+} // namespace packagemanager
@@ -23,6 +23,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <algorithm>
 #include <sstream>
 
 namespace packagemanager
@@ -36,6 +37,18 @@ namespace packagemanager
         const std::string DATA_PATH_KEY_NAME{"datapath"};
         const std::string ANNOTATIONS_FILE_KEY_NAME{"annotationsFile"};
         const std::string ANNOTATIONS_REGEX_KEY_NAME{"annotationsRegex"};
+        const std::string STARTUP_MODE_KEY_NAME{"startupMode"};
+        const std::string WATCH_APPS_PATH_KEY_NAME{"watchAppsPath"};
+        const std::string APP_VOLUMES_KEY_NAME{"appVolumes"};
+        const std::string EVICTION_POLICY_KEY_NAME{"evictionPolicy"};
+        const std::string EVICTION_RESERVE_KEY_NAME{"evictionReserveMB"};
+        const std::string EVICT_SUPERSEDED_ONLY_KEY_NAME{"evictSupersededOnly"};
+        const std::string BACKGROUND_PRIORITY_KEY_NAME{"backgroundPriority"};
+        const std::string DATABASE_KEY_NAME{"database"};
+        const std::string HIBERNATE_AFTER_KEY_NAME{"hibernateAfterSeconds"};
+        const std::string MAX_REHYDRATION_KEY_NAME{"maxRehydrationMs"};
+        const std::string INTERACTIVE_WINDOW_KEY_NAME{"interactiveWindowMs"};
+        const std::string MAX_BACKGROUND_PAUSE_KEY_NAME{"maxBackgroundPauseMs"};
 
         void assureEndsWithSlash(std::string &str)
         {
@@ -45,6 +58,40 @@ namespace packagemanager
             }
         }
 
+        SyncLevel parseSyncLevel(const std::string &value, SyncLevel fallback)
+        {
+            if (value == "off")
+            {
+                return SyncLevel::OFF;
+            }
+            if (value == "normal")
+            {
+                return SyncLevel::NORMAL;
+            }
+            return value == "full" ? SyncLevel::FULL : fallback;
+        }
+
+        TempStore parseTempStore(const std::string &value)
+        {
+            if (value == "file")
+            {
+                return TempStore::FILE;
+            }
+            return value == "memory" ? TempStore::MEMORY : TempStore::DEFAULT;
+        }
+
+        AppVolume createAppVolume(const std::string &name, std::string path)
+        {
+            AppVolume volume;
+            assureEndsWithSlash(path);
+            volume.name = name;
+            volume.path = path;
+            volume.tmpPath = path + APPS_TMP_DIR_NAME + '/';
+            volume.trashPath = path + APPS_TRASH_DIR_NAME + '/';
+            volume.hibernatedPath = path + APPS_HIBERNATED_DIR_NAME + '/';
+            return volume;
+        }
+
     } // namespace anonymous
 
     Config::Config(const std::string &aConfig)
@@ -52,6 +99,7 @@ namespace packagemanager
         std::stringstream ss{aConfig};
         boost::property_tree::ptree pt;
 
+        std::vector<AppVolume> extraVolumes;
         try
         {
             boost::property_tree::read_json(ss, pt);
@@ -65,10 +113,12 @@ namespace packagemanager
                 {
                     appsPath = it->second.get_value<std::string>();
                     assureEndsWithSlash(appsPath);
-                    appsTmpPath = appsPath + "tmp/";
+                    appsTmpPath = appsPath + APPS_TMP_DIR_NAME + '/';
+                    appsTrashPath = appsPath + APPS_TRASH_DIR_NAME + '/';
 
                     DEBUG("appsPath ", appsPath);
                     DEBUG("appsTmpPath ", appsTmpPath);
+                    DEBUG("appsTrashPath ", appsTrashPath);
                 }
                 else if (it->first == DB_PATH_KEY_NAME)
                 {
@@ -100,12 +150,105 @@ namespace packagemanager
                 {
                     configUrl = it->second.get_value<std::string>();
                 }
+                else if (it->first == STARTUP_MODE_KEY_NAME)
+                {
+                    startupMode = it->second.get_value<std::string>() == "lazy" ? StartupMode::LAZY : StartupMode::FULL;
+                    DEBUG("startupMode ", it->second.get_value<std::string>());
+                }
+                else if (it->first == WATCH_APPS_PATH_KEY_NAME)
+                {
+                    watchAppsPath = it->second.get_value<bool>();
+                    DEBUG("watchAppsPath ", watchAppsPath);
+                }
+                else if (it->first == APP_VOLUMES_KEY_NAME)
+                {
+                    // [{"name":"usb","path":"/media/usb/apps","speed":"slow","capacityMB":4096}, ...]
+                    for (const auto &item : it->second)
+                    {
+                        // an invalid entry must not end parsing, the keys after it would be lost
+                        auto name = item.second.get<std::string>("name", "");
+                        auto path = item.second.get<std::string>("path", "");
+                        if (name.empty() || path.empty())
+                        {
+                            WARNING("app volume without name or path ignored");
+                            continue;
+                        }
+                        auto volume = createAppVolume(name, path);
+                        volume.speed = item.second.get<std::string>("speed", "slow") == "fast" ? VolumeSpeed::FAST : VolumeSpeed::SLOW;
+                        volume.capacity = item.second.get<unsigned long long>("capacityMB", 0) * 1024 * 1024;
+                        DEBUG("appVolume ", volume.name, " ", volume.path);
+                        extraVolumes.push_back(volume);
+                    }
+                }
+                else if (it->first == EVICTION_POLICY_KEY_NAME)
+                {
+                    evictionPolicy = it->second.get_value<std::string>() == "lru" ? EvictionPolicy::LRU : EvictionPolicy::NONE;
+                    DEBUG("evictionPolicy ", it->second.get_value<std::string>());
+                }
+                else if (it->first == EVICTION_RESERVE_KEY_NAME)
+                {
+                    evictionReserve = it->second.get_value<unsigned long long>() * 1024 * 1024;
+                    DEBUG("evictionReserve ", evictionReserve);
+                }
+                else if (it->first == EVICT_SUPERSEDED_ONLY_KEY_NAME)
+                {
+                    evictSupersededOnly = it->second.get_value<bool>();
+                    DEBUG("evictSupersededOnly ", evictSupersededOnly);
+                }
+                else if (it->first == BACKGROUND_PRIORITY_KEY_NAME)
+                {
+                    backgroundPriority.enabled = true;
+                    backgroundPriority.ioClass = it->second.get<std::string>("ioClass", "idle") == "best-effort" ? IoClass::BEST_EFFORT : IoClass::IDLE;
+                    backgroundPriority.ioLevel = std::min(std::max(it->second.get<int>("ioLevel", 7), 0), 7);
+                    backgroundPriority.nice = std::min(std::max(it->second.get<int>("nice", 10), -20), 19);
+                    DEBUG("backgroundPriority ioLevel ", backgroundPriority.ioLevel, " nice ", backgroundPriority.nice);
+                }
+                else if (it->first == DATABASE_KEY_NAME)
+                {
+                    auto &database = databaseProfile;
+                    database.journalMode = it->second.get<std::string>("journalMode", "delete") == "wal" ? JournalMode::WAL : JournalMode::DELETE;
+                    // NORMAL is as safe as FULL against corruption in WAL mode and syncs only on checkpoints
+                    database.synchronous = parseSyncLevel(it->second.get<std::string>("synchronous", ""),
+                                                          database.journalMode == JournalMode::WAL ? SyncLevel::NORMAL : SyncLevel::FULL);
+                    database.mmapSize = std::max(it->second.get<long long>("mmapSizeKB", 0), 0LL) * 1024;
+                    // negative cache_size is in KiB
+                    database.cacheSize = -std::max(it->second.get<long long>("cacheSizeKB", 2000), 1LL);
+                    database.tempStore = parseTempStore(it->second.get<std::string>("tempStore", "default"));
+                    database.readConnections = it->second.get<unsigned int>("readConnections", 4);
+                    DEBUG("database wal ", database.journalMode == JournalMode::WAL, " mmapSize ", database.mmapSize);
+                }
+                else if (it->first == HIBERNATE_AFTER_KEY_NAME)
+                {
+                    hibernateAfter = it->second.get_value<unsigned long long>();
+                    DEBUG("hibernateAfter ", hibernateAfter);
+                }
+                else if (it->first == MAX_REHYDRATION_KEY_NAME)
+                {
+                    maxRehydrationTime = it->second.get_value<unsigned long long>();
+                    DEBUG("maxRehydrationTime ", maxRehydrationTime);
+                }
+                else if (it->first == INTERACTIVE_WINDOW_KEY_NAME)
+                {
+                    interactiveWindow = it->second.get_value<unsigned long long>();
+                    DEBUG("interactiveWindow ", interactiveWindow);
+                }
+                else if (it->first == MAX_BACKGROUND_PAUSE_KEY_NAME)
+                {
+                    maxBackgroundPause = it->second.get_value<unsigned long long>();
+                    DEBUG("maxBackgroundPause ", maxBackgroundPause);
+                }
             }
         }
         catch (std::exception &exc)
         {
             ERROR("parsing config exception: ", exc.what());
         }
+
+        if (!appsPath.empty())
+        {
+            appVolumes.push_back(createAppVolume({}, appsPath));
+            appVolumes.insert(appVolumes.end(), extraVolumes.begin(), extraVolumes.end());
+        }
     }
 
     const std::string &Config::getDatabasePath() const
@@ -123,6 +266,11 @@ namespace packagemanager
         return appsPath;
     }
 
+    const std::string &Config::getAppsTrashPath() const
+    {
+        return appsTrashPath;
+    }
+
     const std::string &Config::getAnnotationsFile() const
     {
         return annotationsFile;
@@ -150,6 +298,78 @@ namespace packagemanager
         return configUrl;
     }
 
+    StartupMode Config::getStartupMode() const
+    {
+        return startupMode;
+    }
+
+    bool Config::getWatchAppsPath() const
+    {
+        return watchAppsPath;
+    }
+
+    const std::vector<AppVolume> &Config::getAppVolumes() const
+    {
+        return appVolumes;
+    }
+
+    const AppVolume *Config::findAppVolume(const std::string &name) const
+    {
+        for (const auto &volume : appVolumes)
+        {
+            if (volume.name == name)
+            {
+                return &volume;
+            }
+        }
+        return nullptr;
+    }
+
+    EvictionPolicy Config::getEvictionPolicy() const
+    {
+        return evictionPolicy;
+    }
+
+    unsigned long long Config::getEvictionReserve() const
+    {
+        return evictionReserve;
+    }
+
+    bool Config::getEvictSupersededOnly() const
+    {
+        return evictSupersededOnly;
+    }
+
+    const PriorityProfile &Config::getBackgroundPriority() const
+    {
+        return backgroundPriority;
+    }
+
+    const DatabaseProfile &Config::getDatabaseProfile() const
+    {
+        return databaseProfile;
+    }
+
+    unsigned long long Config::getHibernateAfter() const
+    {
+        return hibernateAfter;
+    }
+
+    unsigned long long Config::getMaxRehydrationTime() const
+    {
+        return maxRehydrationTime;
+    }
+
+    unsigned long long Config::getInteractiveWindow() const
+    {
+        return interactiveWindow;
+    }
+
+    unsigned long long Config::getMaxBackgroundPause() const
+    {
+        return maxBackgroundPause;
+    }
+
     std::ostream &operator<<(std::ostream &out, const Config &config)
     {
         return out << "[appsPath: " << config.appsPath << " tmpPath: " << config.appsTmpPath 
@@ -158,6 +378,12 @@ namespace packagemanager
                    << " dacBundlePlatformNameOverride: " << config.dacBundlePlatformNameOverride
                    << " dacBundleFirmwareCompatibilityKey: " << config.dacBundleFirmwareCompatibilityKey
                    << " configUrl: " << config.configUrl
+                   << " startupMode: " << (config.startupMode == StartupMode::LAZY ? "lazy" : "full")
+                   << " watchAppsPath: " << config.watchAppsPath
+                   << " appVolumes: " << config.appVolumes.size()
+                   << " evictionPolicy: " << (config.evictionPolicy == EvictionPolicy::LRU ? "lru" : "none")
+                   << " hibernateAfter: " << config.hibernateAfter
+                   << " interactiveWindow: " << config.interactiveWindow
                    << "]";
     };
 
@@ -0,0 +1,185 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConnectionPool.h"
+#include "DataStorage.h"
+#include "Debug.h"
+
+namespace packagemanager
+{
+    namespace
+    {
+        // a reader may wait for a checkpoint, a writer for a writer of another process
+        constexpr int BUSY_TIMEOUT_MS = 5000;
+    }
+
+    ConnectionPool::Lease::Lease(ConnectionPool &pool, Connection *connection, bool writer)
+        : pool(&pool), connection(connection), writer(writer)
+    {
+    }
+
+    ConnectionPool::Lease::Lease(Lease &&other) : pool(other.pool), connection(other.connection), writer(other.writer)
+    {
+        other.pool = nullptr;
+    }
+
+    ConnectionPool::Lease::~Lease()
+    {
+        if (pool)
+        {
+            pool->release(connection, writer);
+        }
+    }
+
+    void ConnectionPool::Lease::invalidate() const
+    {
+        // a reader lease does not write, only the writer's invalidation is kept
+        if (writer)
+        {
+            pool->writerInvalidated = true;
+        }
+    }
+
+    ConnectionPool::~ConnectionPool()
+    {
+        close();
+    }
+
+    sqlite3 *ConnectionPool::openConnection(const std::string &path, int flags)
+    {
+        sqlite3 *db{nullptr};
+        int rc = sqlite3_open_v2(path.c_str(), &db, flags | SQLITE_OPEN_NOMUTEX, nullptr);
+        if (rc != SQLITE_OK)
+        {
+            auto msg = std::string{"Error opening connection: "} + std::to_string(rc) + " - " + sqlite3_errmsg(db);
+            sqlite3_close(db);
+            throw DataStorageError(msg);
+        }
+        sqlite3_busy_timeout(db, BUSY_TIMEOUT_MS);
+        return db;
+    }
+
+    void ConnectionPool::open(const std::string &newPath, unsigned int newMaxReaders, const std::string &newReaderSetup)
+    {
+        close();
+        path = newPath;
+        maxReaders = newMaxReaders;
+        readerSetup = newReaderSetup;
+
+        std::unique_ptr<Connection> connection{new Connection};
+        connection->db = openConnection(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+        connection->statements.reset(connection->db);
+        writerConnection = std::move(connection);
+        writerInvalidated = false;
+        ++writeGeneration;
+    }
+
+    void ConnectionPool::close()
+    {
+        // sqlite3_close fails while statements are not finalized
+        std::lock_guard<std::mutex> lock(readersMutex);
+        for (auto &reader : readers)
+        {
+            reader->statements.reset(nullptr);
+            sqlite3_close(reader->db);
+        }
+        readers.clear();
+        idleReaders.clear();
+        if (writerConnection)
+        {
+            writerConnection->statements.reset(nullptr);
+            sqlite3_close(writerConnection->db);
+            writerConnection.reset();
+        }
+    }
+
+    ConnectionPool::Lease ConnectionPool::writer()
+    {
+        if (!writerConnection)
+        {
+            throw DataStorageError("database is not open");
+        }
+        writerMutex.lock();
+        writerOwner = std::this_thread::get_id();
+        ++writerDepth;
+        return Lease{*this, writerConnection.get(), true};
+    }
+
+    ConnectionPool::Lease ConnectionPool::reader()
+    {
+        if (!maxReaders || writerOwner.load() == std::this_thread::get_id())
+        {
+            return writer();
+        }
+
+        std::unique_lock<std::mutex> lock(readersMutex);
+        while (idleReaders.empty() && readers.size() >= maxReaders)
+        {
+            readerReturned.wait(lock);
+        }
+        if (!idleReaders.empty())
+        {
+            auto connection = idleReaders.back();
+            idleReaders.pop_back();
+            return Lease{*this, connection, false};
+        }
+
+        std::unique_ptr<Connection> connection{new Connection};
+        connection->db = openConnection(path, SQLITE_OPEN_READONLY);
+        if (!readerSetup.empty() && sqlite3_exec(connection->db, readerSetup.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+        {
+            WARNING("[ConnectionPool::reader] setup failed: ", sqlite3_errmsg(connection->db));
+        }
+        connection->statements.reset(connection->db);
+        readers.push_back(std::move(connection));
+        DEBUG("[ConnectionPool::reader] opened reader ", readers.size());
+        return Lease{*this, readers.back().get(), false};
+    }
+
+    void ConnectionPool::release(Connection *connection, bool writer)
+    {
+        if (writer)
+        {
+            if (--writerDepth == 0)
+            {
+                writerOwner = std::thread::id{};
+                // after the outermost savepoint, nothing newer is visible before the commit
+                if (writerInvalidated)
+                {
+                    writerInvalidated = false;
+                    ++writeGeneration;
+                }
+            }
+            writerMutex.unlock();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(readersMutex);
+            idleReaders.push_back(connection);
+        }
+        readerReturned.notify_one();
+    }
+
+    std::size_t ConnectionPool::openReaders() const
+    {
+        std::lock_guard<std::mutex> lock(readersMutex);
+        return readers.size();
+    }
+
+} // namespace packagemanager
@@ -0,0 +1,196 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Digest.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace packagemanager
+{
+    namespace Digest
+    {
+        namespace
+        {
+            constexpr uint32_t K[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+            inline uint32_t rotr(uint32_t x, unsigned n)
+            {
+                return (x >> n) | (x << (32 - n));
+            }
+        } // namespace
+
+        Sha256::Sha256()
+        {
+            reset();
+        }
+
+        void Sha256::reset()
+        {
+            state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+            buffered = 0;
+            length = 0;
+        }
+
+        void Sha256::transform(const uint8_t *block)
+        {
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i)
+            {
+                w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) |
+                       (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+            }
+            for (int i = 16; i < 64; ++i)
+            {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i)
+            {
+                uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                uint32_t ch = (e & f) ^ (~e & g);
+                uint32_t t1 = h + s1 + ch + K[i] + w[i];
+                uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                uint32_t t2 = s0 + maj;
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+
+        void Sha256::update(const void *data, std::size_t size)
+        {
+            auto bytes = static_cast<const uint8_t *>(data);
+            length += size;
+            if (buffered)
+            {
+                std::size_t take = std::min(size, buffer.size() - buffered);
+                std::memcpy(buffer.data() + buffered, bytes, take);
+                buffered += take;
+                bytes += take;
+                size -= take;
+                if (buffered < buffer.size())
+                {
+                    return;
+                }
+                transform(buffer.data());
+                buffered = 0;
+            }
+            for (; size >= buffer.size(); bytes += buffer.size(), size -= buffer.size())
+            {
+                transform(bytes);
+            }
+            std::memcpy(buffer.data(), bytes, size);
+            buffered = size;
+        }
+
+        std::string Sha256::finish()
+        {
+            uint64_t bits = length * 8;
+            uint8_t padding[72]{0x80};
+            std::size_t padLength = (buffered < 56 ? 56 : 120) - buffered;
+            for (int i = 0; i < 8; ++i)
+            {
+                padding[padLength + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+            }
+            update(padding, padLength + 8);
+
+            static const char hex[] = "0123456789abcdef";
+            std::string digest;
+            digest.reserve(64);
+            for (auto word : state)
+            {
+                for (int shift = 28; shift >= 0; shift -= 4)
+                {
+                    digest += hex[(word >> shift) & 0xf];
+                }
+            }
+            return digest;
+        }
+
+        std::string sha256File(const std::string &path)
+        {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                ERROR("[Digest::sha256File] Unable to open ", path);
+                return {};
+            }
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+            Sha256 sha;
+            char buffer[64 * 1024];
+            ssize_t bytesRead;
+            while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                sha.update(buffer, static_cast<std::size_t>(bytesRead));
+            }
+            close(fd);
+            if (bytesRead < 0)
+            {
+                ERROR("[Digest::sha256File] Unable to read ", path);
+                return {};
+            }
+            return sha.finish();
+        }
+
+        std::string sha256Tree(const std::map<std::string, std::string> &fileDigests)
+        {
+            Sha256 sha;
+            for (const auto &file : fileDigests)
+            {
+                sha.update(file.first.data(), file.first.size());
+                sha.update("", 1);
+                sha.update(file.second.data(), file.second.size());
+                sha.update("\n", 1);
+            }
+            return sha.finish();
+        }
+
+    } // namespace Digest
+} // namespace packagemanager
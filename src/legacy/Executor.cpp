@@ -23,8 +23,10 @@
 #include "Archives.h"
 #include "Config.h"
 #include "Debug.h"
+#include "Digest.h"
 #include "Filesystem.h"
 #include "SqlDataStorage.h"
+#include "ThreadPriority.h"
 
 #include <array>
 #include <cassert>
@@ -32,10 +34,14 @@
 #include <limits>
 #include <fstream>
 #include <regex>
+#include <set>
 #include <algorithm>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/filesystem.hpp>
+#include <chrono>
+#include <ctime>
+#include <unistd.h>
 
 #ifdef UNIT_TESTS
 namespace Core
@@ -52,6 +58,45 @@ namespace packagemanager
 {
     namespace // anonymous
     {
+        // zstd level of hibernated apps, packing runs rarely and decompression speed barely depends on it
+        constexpr int HIBERNATION_COMPRESSION_LEVEL = 9;
+        const std::string HIBERNATED_ARCHIVE_SUFFIX{".tar.zst"};
+        const std::string HIBERNATED_ANNOTATIONS_SUFFIX{".json"};
+
+        // foreground jobs keep the priority of the calling thread
+        const PriorityProfile CALLER_PRIORITY{};
+
+        // <hibernatedPath><id>_<version>, followed by one of the suffixes above
+        std::string hibernatedBasePath(const AppVolume &volume, const std::string &id, const std::string &version)
+        {
+            return volume.hibernatedPath + id + '_' + version;
+        }
+
+        // completes "App is being ..."
+        const char *removalName(LockRegistry::BlockReason reason)
+        {
+            using BlockReason = LockRegistry::BlockReason;
+            return reason == BlockReason::UNINSTALL     ? "uninstalled"
+                   : reason == BlockReason::REINSTALL   ? "reinstalled"
+                   : reason == BlockReason::EVICTION    ? "evicted"
+                   : reason == BlockReason::HIBERNATION ? "hibernated"
+                                                        : "removed";
+        }
+
+        bool fileExists(const std::string &path)
+        {
+            boost::system::error_code ec;
+            return boost::filesystem::is_regular_file(path, ec);
+        }
+
+        void removeFile(const std::string &path)
+        {
+            boost::system::error_code ec;
+            if (!boost::filesystem::remove(path, ec) && ec)
+            {
+                WARNING("Unable to remove ", path, ": ", ec.message());
+            }
+        }
 
         std::string extractFilename(const std::string &uri)
         {
@@ -122,12 +167,53 @@ namespace packagemanager
             return apps;
         }
 
+        // Same as scanDirectories, but from the watcher model instead of listing the tree
+        std::vector<AppId> watchedDirectories(AppsWatcher &watcher, const std::string &appsPath)
+        {
+            std::vector<AppId> apps;
+            for (const auto &idVersions : watcher.getAppDirectories())
+            {
+                if (idVersions.second.empty())
+                {
+                    // fails for an id directory with stray files, scanDirectories leaves those alone too
+                    DEBUG("empty dir: ", appsPath, idVersions.first, " removing");
+                    rmdir((appsPath + idVersions.first).c_str());
+                    continue;
+                }
+                for (const auto &version : idVersions.second)
+                {
+                    apps.push_back(AppId{idVersions.first, version});
+                }
+            }
+            return apps;
+        }
+
     } // namespace anonymous
 
+    Executor::~Executor()
+    {
+        waitForBackgroundTasks();
+        if (journal)
+        {
+            try
+            {
+                journal->markCleanShutdown();
+            }
+            catch (std::exception &error)
+            {
+                ERROR("[Executor::~Executor] Unable to record clean shutdown: ", error.what());
+            }
+        }
+    }
+
     uint32_t Executor::Configure(const std::string &configString)
     {
         INFO("[Executor::Configure] config: '", configString, "'");
+        // the deferred startup work of a previous Configure still reads config
+        waitForBackgroundTasks();
         config = Config{configString};
+        scheduler.configure(std::chrono::milliseconds(config.getInteractiveWindow()),
+                            std::chrono::milliseconds(config.getMaxBackgroundPause()));
 
         auto result{RETURN_SUCCESS};
         if (config.getAppsPath().empty() || config.getDatabasePath().empty())
@@ -138,8 +224,50 @@ namespace packagemanager
         try
         {
             handleDirectories();
-            initializeDataBase(config.getDatabasePath());
-            doMaintenance();
+            startAppsWatcher();
+            reapers.clear();
+            for (const auto &volume : config.getAppVolumes())
+            {
+                reapers.push_back(nullptr);
+                if (isVolumeAvailable(volume))
+                {
+                    reapers.back() = std::make_unique<TrashReaper>(volume.trashPath);
+                    reapers.back()->start();
+                }
+            }
+
+            std::vector<Journal::Entry> incomplete;
+            bool cleanShutdown{false};
+            bool journalTrusted = openJournal(incomplete, cleanShutdown);
+
+            // Lazy startup trusts a clean shutdown and otherwise only runs the O(N) quick_check,
+            // the full integrity_check and a full maintenance (if needed) run in the background.
+            bool lazy = config.getStartupMode() == StartupMode::LAZY;
+            auto check = DataStorage::IntegrityCheck::FULL;
+            if (lazy && journalTrusted)
+            {
+                check = cleanShutdown ? DataStorage::IntegrityCheck::NONE : DataStorage::IntegrityCheck::QUICK;
+            }
+            initializeDataBase(config.getDatabasePath(), check);
+
+            bool fullMaintenance = !journalTrusted || dataBase->WasCreated();
+            if (lazy)
+            {
+                if (fullMaintenance)
+                {
+                    // until the background run finished the next start must not trust the journal
+                    journal->markDirty();
+                }
+                else
+                {
+                    recover(incomplete, false);
+                }
+                backgroundThread = std::thread(&Executor::runDeferredStartup, this, fullMaintenance);
+            }
+            else
+            {
+                recover(incomplete, fullMaintenance);
+            }
             INFO("[Executor::Configure] configuration done");
         }
         catch (std::exception &error)
@@ -155,7 +283,10 @@ namespace packagemanager
                                const std::string &version,
                                const std::string &url,
                                const std::string &appName,
-                               const std::string &category)
+                               const std::string &category,
+                               UsageHint hint,
+                               ReinstallCheck check,
+                               JobPriority priority)
     {
         INFO("[ Executor::Install] type=", type, " id=", id, " version=", version, " url=", url, " appName=", appName, " cat=", category);
 
@@ -171,34 +302,116 @@ namespace packagemanager
             return RETURN_ERROR;
         }
 
+        ScopedThreadPriority scopedPriority{profileFor(priority)};
+
+        // hashed outside of taskMutex, concurrent installs of different archives hash in parallel
+        auto digest = Digest::sha256File(url);
+        if (digest.empty())
+        {
+            return doInstall(type, id, version, url, appName, category, hint, digest, check, priority);
+        }
+        DEBUG("[Executor::Install] archive sha256=", digest);
+
+        // a duplicate of an install in progress waits for it instead of failing as already installed
+        bool shared{false};
+        InstallKey key{type, id, version, digest, appName, category, hint, check, priority};
+        auto result = installFlights.run(key, [&]()
+        {
+            return doInstall(type, id, version, url, appName, category, hint, digest, check, priority);
+        }, &shared);
+        if (shared)
+        {
+            INFO("[Executor::Install] id=", id, " version=", version, " joined an identical install in progress, result=", result);
+        }
+        return result;
+    }
+
+    uint32_t Executor::doInstall(const std::string &type,
+                                 const std::string &id,
+                                 const std::string &version,
+                                 const std::string &url,
+                                 const std::string &appName,
+                                 const std::string &category,
+                                 UsageHint hint,
+                                 const std::string &digest,
+                                 ReinstallCheck check,
+                                 JobPriority priority)
+    {
         LockGuard lock(taskMutex);
 
         if (isAppInstalled(type, id, version))
         {
-            ERROR("[Executor::Install] App is already installed!");
-            return RETURN_ERROR;
+            if (digest.empty() || dataBase->GetArchiveDigest(id, version) != digest)
+            {
+                ERROR("[Executor::Install] App is already installed!");
+                return RETURN_ERROR;
+            }
+            auto state = verifyInstalled(id, version, url, check);
+            if (state == InstalledState::INTACT)
+            {
+                INFO("[Executor::Install] id=", id, " version=", version, " already installed from an identical archive");
+                return RETURN_SUCCESS;
+            }
+            if (state == InstalledState::UNAVAILABLE)
+            {
+                ERROR("[Executor::Install] id=", id, " version=", version, " is installed on an app volume that is not available");
+                return RETURN_ERROR;
+            }
+
+            // damaged install of the same archive, replaced keeping the app data
+            if (!lockedApps.blockIfUnlocked(id, version, LockRegistry::BlockReason::REINSTALL))
+            {
+                ERROR("[Executor::Install] id=", id, " version=", version, " is damaged but locked");
+                return RETURN_ERROR;
+            }
+            WARNING("[Executor::Install] id=", id, " version=", version, " is damaged, reinstalling");
+            try
+            {
+                doUninstall(type, id, version, "upgrade");
+            }
+            catch (std::exception &error)
+            {
+                ERROR("[Executor::Install] Unable to remove damaged install: ", error.what());
+                lockedApps.unblock(id, version);
+                return RETURN_ERROR;
+            }
+            lockedApps.unblock(id, version);
         }
 
         try
         {
-            if (dataBase->GetTypeOfApp(id) != type)
+            auto catalog = GetCatalogSnapshot();
+            auto row = catalog->find(id);
+            // no row is fine, not a single version of app(id) installed yet
+            if (row != CatalogSnapshot::npos && (*catalog)[row].type != type)
             {
                 ERROR("[Executor::Install] In the DB id '", id, "' is already used with another type! App id must be unique.");
                 return RETURN_ERROR;
             }
         }
-        catch (const SqlDataStorageError &)
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::Install] Unable to read the catalog: ", error.what());
+            return RETURN_ERROR;
+        }
+        bool status{false};
+        try
+        {
+            status = extract(type, id, version, url, appName, category, hint, digest, priority);
+        }
+        catch (std::exception &error)
         {
-            // fine, no problem, not a single version of app(id) installed yet
+            // an open journal entry is rolled back on the next start
+            ERROR("[Executor::Install] Unable to install: ", error.what());
         }
-        bool status = extract(type, id, version, url, appName, category);
         return status ? RETURN_SUCCESS : RETURN_ERROR;
     }
 
     uint32_t Executor::Uninstall(const std::string &type,
                                  const std::string &id,
                                  const std::string &version,
-                                 const std::string &uninstallType)
+                                 const std::string &uninstallType,
+                                 JobPriority priority)
     {
         INFO("[Executor::Uninstall] type=", type, " id=", id, " version=", version, " uninstallType=", uninstallType);
 
@@ -224,7 +437,13 @@ namespace packagemanager
             }
             // only allowed when no specific version of app installed anymore
             // if there are: the usual uninstall with a specific version should be called
-            if (dataBase->GetAppsPaths(type, id, "").size() > 0)
+            bool versionInstalled{false};
+            dataBase->VisitAppDetails([&versionInstalled](const DataStorage::AppDetailsView &)
+            {
+                versionInstalled = true;
+                return false;
+            }, false, type, id);
+            if (versionInstalled)
             {
                 ERROR("[Executor::Uninstall] There are still versions of app installed for type=", type, " id=", id);
                 return RETURN_ERROR;
@@ -236,16 +455,179 @@ namespace packagemanager
             return RETURN_ERROR;
         }
         INFO("[Executor::Uninstall] We are good to uninstall");
+        ScopedThreadPriority scopedPriority{profileFor(priority)};
         LockGuard lock(taskMutex);
 
-        if (std::find(lockedApps.begin(), lockedApps.end(), std::make_pair(id, version)) != lockedApps.end())
+        if (lockedApps.deferUninstallOrBlock(id, version, {type, uninstallType}))
         {
-            ERROR("Cannot uninstall app because of lock!");
-            return RETURN_ERROR;
+            INFO("[Executor::Uninstall] App is locked, uninstall deferred until it is unlocked");
+            return RETURN_SUCCESS;
         }
         INFO("[Executor::Uninstall] App is not locked, proceeding with uninstall");
 
-        doUninstall(type, id, version, uninstallType);
+        // a Lock arriving meanwhile fails instead of starting an app that is being removed
+        try
+        {
+            doUninstall(type, id, version, uninstallType);
+        }
+        catch (...)
+        {
+            lockedApps.unblock(id, version);
+            throw;
+        }
+        lockedApps.unblock(id, version);
+        return RETURN_SUCCESS;
+    }
+
+    uint32_t Executor::Lock(const std::string &id,
+                            const std::string &version)
+    {
+        if (id.empty() || version.empty())
+        {
+            ERROR("[Executor::Lock] id or version is empty");
+            return RETURN_ERROR;
+        }
+
+        // Register first so that a concurrent Uninstall already sees the lock
+        LockRegistry::BlockReason blockedBy{};
+        auto count = lockedApps.lock(id, version, &blockedBy);
+        if (count == 0)
+        {
+            ERROR("[Executor::Lock] App is being ", removalName(blockedBy), ": id=", id, " version=", version);
+            return RETURN_ERROR;
+        }
+        if (!isAppInstalled("", id, version))
+        {
+            ERROR("[Executor::Lock] App not installed: id=", id, " version=", version);
+            Unlock(id, version);
+            return RETURN_ERROR;
+        }
+        if (!rehydrate(id, version))
+        {
+            ERROR("[Executor::Lock] Unable to rehydrate id=", id, " version=", version);
+            Unlock(id, version);
+            return RETURN_ERROR;
+        }
+        if (count == 1)
+        {
+            try
+            {
+                dataBase->SetLastLocked(id, version, std::time(nullptr));
+            }
+            catch (std::exception &error)
+            {
+                WARNING("[Executor::Lock] Unable to record last lock time: ", error.what());
+            }
+        }
+        // noted once the app is extracted, a rehydration still waits for a paused install to finish
+        scheduler.noteInteractive();
+        DEBUG("[Executor::Lock] id=", id, " version=", version, " locks=", count);
+        return RETURN_SUCCESS;
+    }
+
+    uint32_t Executor::Unlock(const std::string &id,
+                              const std::string &version)
+    {
+        unsigned int remaining{};
+        if (!lockedApps.unlock(id, version, remaining))
+        {
+            ERROR("[Executor::Unlock] App is not locked: id=", id, " version=", version);
+            return RETURN_ERROR;
+        }
+        DEBUG("[Executor::Unlock] id=", id, " version=", version, " locks=", remaining);
+
+        if (remaining == 0)
+        {
+            LockGuard lock(taskMutex);
+
+            // re-checked under taskMutex, the app may have been locked again meanwhile
+            LockRegistry::DeferredUninstall uninstall{};
+            if (lockedApps.takeDeferredUninstall(id, version, uninstall))
+            {
+                INFO("[Executor::Unlock] Running deferred uninstall of id=", id, " version=", version);
+                ScopedThreadPriority scopedPriority{config.getBackgroundPriority()};
+                try
+                {
+                    doUninstall(uninstall.type, id, version, uninstall.uninstallType);
+                }
+                catch (std::exception &error)
+                {
+                    ERROR("[Executor::Unlock] Deferred uninstall failed: ", error.what());
+                    lockedApps.unblock(id, version);
+                    return RETURN_ERROR;
+                }
+                lockedApps.unblock(id, version);
+            }
+        }
+        return RETURN_SUCCESS;
+    }
+
+    uint32_t Executor::HibernateIdleApps(unsigned int &hibernated)
+    {
+        hibernated = 0;
+        auto idleSeconds = config.getHibernateAfter();
+        if (!idleSeconds)
+        {
+            DEBUG("[Executor::HibernateIdleApps] hibernation is not enabled");
+            return RETURN_SUCCESS;
+        }
+        auto maxRehydrationTime = static_cast<long long>(config.getMaxRehydrationTime());
+        ScopedThreadPriority scopedPriority{config.getBackgroundPriority()};
+        try
+        {
+            auto lockedBefore = static_cast<long long>(std::time(nullptr)) - static_cast<long long>(idleSeconds);
+            for (const auto &candidate : dataBase->GetHibernationCandidates(lockedBefore))
+            {
+                if (maxRehydrationTime && candidate.rehydrationTime > maxRehydrationTime)
+                {
+                    DEBUG("[Executor::HibernateIdleApps] id=", candidate.id, " version=", candidate.version,
+                          " kept extracted, rehydration took ", candidate.rehydrationTime, " ms");
+                    continue;
+                }
+                if (lockedApps.isLocked(candidate.id, candidate.version))
+                {
+                    continue;
+                }
+                // one version at a time, installs and launches are not held up by the whole pass
+                LockGuard lock(taskMutex);
+                if (hibernate(candidate))
+                {
+                    ++hibernated;
+                }
+            }
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::HibernateIdleApps] ", error.what());
+            return RETURN_ERROR;
+        }
+        INFO("[Executor::HibernateIdleApps] hibernated ", hibernated, " app versions");
+        return RETURN_SUCCESS;
+    }
+
+    IoScheduler::Stats Executor::GetSchedulerStats() const
+    {
+        return scheduler.getStats();
+    }
+
+    uint32_t Executor::GetEvictionPlan(unsigned long long requiredBytes,
+                                       UsageHint hint,
+                                       std::vector<DataStorage::EvictionCandidate> &plan)
+    {
+        try
+        {
+            plan.clear();
+            if (!planEviction(hint, requiredBytes, plan))
+            {
+                INFO("[Executor::GetEvictionPlan] ", requiredBytes, " bytes can not be made available");
+                return RETURN_ERROR;
+            }
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::GetEvictionPlan] Unable to plan eviction: ", error.what());
+            return RETURN_ERROR;
+        }
         return RETURN_SUCCESS;
     }
 
@@ -258,12 +640,14 @@ namespace packagemanager
 
         try
         {
-            // if all params are empty then the overall disk usage is calculated
+            // if all params are empty then the overall disk usage is reported.
+            // Usage is accounted in the catalog on install/uninstall, tmp is transient
+            // and emptied after every operation so it is not part of the total.
             if (type.empty() && id.empty() && version.empty())
             {
                 INFO("[Executor::GetStorageDetails] Calculating overall usage");
                 details.appPath = config.getAppsPath();
-                details.appUsedKB = std::to_string((fs::getDirectorySpace(config.getAppsPath()) + fs::getDirectorySpace(config.getAppsTmpPath())) / 1024);
+                details.appUsedKB = std::to_string(dataBase->GetTotalUsage().bytes / 1024);
             }
             else if (!id.empty())
             {
@@ -274,18 +658,21 @@ namespace packagemanager
                 INFO("[Executor::GetStorageDetails] Calculating usage for: type = ", type, " id = ", id, " version = ", version);
                 if (!version.empty())
                 {
-                    std::vector<std::string> appsPaths = dataBase->GetAppsPaths(type, id, version);
-                    if (appsPaths.empty())
+                    auto appsLocations = dataBase->GetAppsLocations(type, id, version);
+                    if (appsLocations.empty())
                     {
                         // return error when app not found
                         return RETURN_ERROR;
                     }
                     unsigned long long appUsedKB{};
                     // In Stage 1 there will be only one entry here
-                    for (const auto &i : appsPaths)
+                    for (const auto &location : appsLocations)
                     {
-                        details.appPath = config.getAppsPath() + i;
-                        appUsedKB += fs::getDirectorySpace(details.appPath);
+                        if (!resolveAppPath(location, details.appPath))
+                        {
+                            return RETURN_ERROR;
+                        }
+                        appUsedKB += getAppUsage(type, id, version, details.appPath).bytes;
                     }
                     details.appUsedKB = std::to_string(appUsedKB / 1024);
                 }
@@ -316,13 +703,7 @@ namespace packagemanager
         try
         {
 
-            DataStorage::AppDetails details = dataBase->GetAppDetails(id);
-            appDetails.type = details.type;
-            appDetails.id = details.id;
-            appDetails.version = details.version;
-            appDetails.appName = details.appName;
-            appDetails.category = details.category;
-            appDetails.url = details.url;
+            appDetails = dataBase->GetAppDetails(id);
         }
         catch (std::exception &error)
         {
@@ -331,6 +712,28 @@ namespace packagemanager
         }
         return RETURN_SUCCESS;
     }
+    std::shared_ptr<const CatalogSnapshot> Executor::GetCatalogSnapshot() const
+    {
+        auto generation = dataBase->GetGeneration();
+        auto current = std::atomic_load(&snapshot);
+        if (current && current->generation() == generation)
+        {
+            return current;
+        }
+        // concurrent callers of the same generation share one build
+        return snapshotFlights.run(generation, [this]()
+        {
+            auto built = CatalogSnapshot::build(*dataBase);
+            // a slower build of an older generation does not replace a newer one
+            auto published = std::atomic_load(&snapshot);
+            while ((!published || published->generation() < built->generation()) &&
+                   !std::atomic_compare_exchange_strong(&snapshot, &published, built))
+            {
+            }
+            return built;
+        });
+    }
+
     uint32_t Executor::GetAppDetailsList(const std::string &type,
                                          const std::string &id,
                                          const std::string &version,
@@ -341,7 +744,21 @@ namespace packagemanager
         INFO("[Executor::GetAppDetailsList] for id : ", id, ", version : ", version);
         try
         {
-            appsDetailsList = dataBase->GetAppDetailsListOuterJoin(type, id, version, appName, category);
+            if (type.empty() && id.empty() && version.empty() && appName.empty() && category.empty())
+            {
+                // the whole list is served from the snapshot, no query while the catalog is unchanged
+                auto catalog = GetCatalogSnapshot();
+                appsDetailsList.clear();
+                appsDetailsList.reserve(catalog->size());
+                for (std::size_t row = 0; row < catalog->size(); ++row)
+                {
+                    appsDetailsList.push_back((*catalog)[row].str());
+                }
+            }
+            else
+            {
+                appsDetailsList = dataBase->GetAppDetailsListOuterJoin(type, id, version, appName, category);
+            }
             INFO("[Executor::GetAppDetailsList] Retrieved ", appsDetailsList.size(), " app details");
         }
         catch (std::exception &error)
@@ -436,68 +853,466 @@ namespace packagemanager
         return RETURN_SUCCESS;
     }
 
+    DataStorage::AppUsage Executor::getAppUsage(const std::string &type,
+                                                const std::string &id,
+                                                const std::string &version,
+                                                const std::string &appPath)
+    {
+        DataStorage::AppUsage usage{};
+        if (!dataBase->GetAppUsage(type, id, version, usage))
+        {
+            // installed before usage accounting, walk it once and remember the result
+            INFO("[Executor::getAppUsage] No usage recorded for id=", id, " version=", version, ", scanning ", appPath);
+            dataBase->SetAppUsage(type, id, version, Filesystem::getDirectoryManifest(appPath));
+            dataBase->GetAppUsage(type, id, version, usage);
+        }
+        return usage;
+    }
+
     void Executor::handleDirectories()
     {
+        for (const auto &volume : config.getAppVolumes())
+        {
+            // the layout is only created on an additional volume that is mounted,
+            // never on the mount point of a missing one
+            if (!volume.name.empty() && !Filesystem::directoryExists(volume.path))
+            {
+                WARNING("[Executor::handleDirectories] App volume ", volume.name, " not present at ", volume.path);
+                continue;
+            }
 #if LISA_APPS_GID
-        Filesystem::createDirectory(config.getAppsPath() + Filesystem::LISA_EPOCH, LISA_APPS_GID, false);
+            Filesystem::createDirectory(volume.path + Filesystem::LISA_EPOCH, LISA_APPS_GID, false);
 #else
-        Filesystem::createDirectory(config.getAppsPath() + Filesystem::LISA_EPOCH);
+            Filesystem::createDirectory(volume.path + Filesystem::LISA_EPOCH);
 #endif
-        Filesystem::removeAllDirectoriesExcept(config.getAppsPath(), Filesystem::LISA_EPOCH);
+            // the trash is emptied in the background by the reaper
+            // and tmp is moved there by the first maintenance run
+            Filesystem::removeAllDirectoriesExcept(volume.path, {Filesystem::LISA_EPOCH, APPS_TRASH_DIR_NAME, APPS_TMP_DIR_NAME, APPS_HIBERNATED_DIR_NAME});
+        }
     }
 
-    void Executor::initializeDataBase(const std::string &dbPath)
+    bool Executor::isVolumeAvailable(const AppVolume &volume) const
     {
-        std::string path = dbPath + Filesystem::LISA_EPOCH + '/';
-        Filesystem::ScopedDir dbDir(path);
-        dataBase = std::make_unique<packagemanager::SqlDataStorage>(path);
-        dataBase->Initialize();
-        dbDir.commit();
-        INFO("[Executor::initializeDataBase] Database created");
+        return volume.name.empty() || Filesystem::directoryExists(volume.path + Filesystem::LISA_EPOCH);
     }
 
-    bool Executor::isAppInstalled(const std::string &type,
-                                  const std::string &id,
-                                  const std::string &version)
+    std::vector<AppVolume> Executor::availableVolumes() const
     {
-        auto appInstalled{false};
-        try
+        std::vector<AppVolume> volumes;
+        for (const auto &volume : config.getAppVolumes())
         {
-            appInstalled = dataBase->IsAppInstalled(type, id, version);
+            if (isVolumeAvailable(volume))
+            {
+                volumes.push_back(volume);
+            }
         }
-        catch (std::exception &exc)
+        return volumes;
+    }
+
+    std::vector<const AppVolume *> Executor::volumesByPreference(UsageHint hint) const
+    {
+        // frequently launched (and unclassified) apps try the fast volumes first, rarely used
+        // ones the slow volumes first, within a tier the configuration order decides
+        std::vector<const AppVolume *> volumes;
+        auto preferred = hint == UsageHint::RARE ? VolumeSpeed::SLOW : VolumeSpeed::FAST;
+        for (bool preferredTier : {true, false})
         {
-            ERROR("[Executor::isAppInstalled] error while checking if app installed: ", exc.what());
+            for (const auto &volume : config.getAppVolumes())
+            {
+                if ((volume.speed == preferred) == preferredTier && isVolumeAvailable(volume))
+                {
+                    volumes.push_back(&volume);
+                }
+            }
         }
-        return appInstalled;
+        return volumes;
     }
 
-    void Executor::importAnnotations(const std::string &type,
-                                     const std::string &id,
-                                     const std::string &version,
-                                     const std::string &appPath)
+    unsigned long long Executor::getShortfall(const AppVolume &volume, unsigned long long requiredBytes, unsigned long long reserve)
     {
-        if (config.getAnnotationsFile().empty())
+        unsigned long long shortfall{0};
+        auto freeSpace = Filesystem::getFreeSpace(volume.path);
+        if (freeSpace < requiredBytes + reserve)
         {
-            return;
+            shortfall = requiredBytes + reserve - freeSpace;
         }
-
-        boost::filesystem::path filepath = appPath;
-        filepath /= config.getAnnotationsFile();
-        std::ifstream file(filepath.string());
-        if (!file.good())
+        if (volume.capacity)
         {
-            return;
+            auto used = dataBase->GetVolumeUsage(volume.name).bytes;
+            if (used + requiredBytes > volume.capacity)
+            {
+                shortfall = std::max(shortfall, used + requiredBytes - volume.capacity);
+            }
         }
+        DEBUG("[Executor::getShortfall] ", volume.path, " free=", freeSpace, " required=", requiredBytes, " shortfall=", shortfall);
+        return shortfall;
+    }
 
-        if (!file.is_open())
+    const AppVolume *Executor::chooseVolume(UsageHint hint, unsigned long long requiredBytes)
+    {
+        for (const auto *volume : volumesByPreference(hint))
         {
-            ERROR("[Executor::importAnnotations] Failed to open ", filepath.string());
-            return;
+            if (getShortfall(*volume, requiredBytes, 0) == 0)
+            {
+                return volume;
+            }
         }
+        return nullptr;
+    }
 
-        INFO("[Executor::importAnnotations] Auto importing annotations from ", filepath.string());
-        try
+    const AppVolume *Executor::planEviction(UsageHint hint, unsigned long long requiredBytes,
+                                            std::vector<DataStorage::EvictionCandidate> &plan)
+    {
+        // the first volume in preference order that can be freed enough, partial evictions are never done
+        for (const auto *volume : volumesByPreference(hint))
+        {
+            auto shortfall = getShortfall(*volume, requiredBytes, config.getEvictionReserve());
+            std::vector<DataStorage::EvictionCandidate> volumePlan;
+            unsigned long long freed{0};
+            for (auto &candidate : dataBase->GetEvictionCandidates(volume->name))
+            {
+                if (freed >= shortfall)
+                {
+                    break;
+                }
+                if ((config.getEvictSupersededOnly() && !candidate.superseded) ||
+                    lockedApps.isLocked(candidate.id, candidate.version))
+                {
+                    continue;
+                }
+                if (!candidate.usageRecorded)
+                {
+                    auto appPath = volume->path + Filesystem::createAppPath(candidate.id, candidate.version);
+                    candidate.usage = getAppUsage(candidate.type, candidate.id, candidate.version, appPath);
+                }
+                freed += candidate.usage.bytes;
+                volumePlan.push_back(candidate);
+            }
+            if (freed >= shortfall)
+            {
+                plan = std::move(volumePlan);
+                return volume;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Executor::evict(const DataStorage::EvictionCandidate &candidate)
+    {
+        // a Lock arriving meanwhile fails instead of starting an app that is being removed
+        if (!lockedApps.blockIfUnlocked(candidate.id, candidate.version, LockRegistry::BlockReason::EVICTION))
+        {
+            INFO("[Executor::evict] id=", candidate.id, " version=", candidate.version, " was locked meanwhile");
+            return false;
+        }
+
+        bool evicted{false};
+        try
+        {
+            INFO("[Executor::evict] Evicting id=", candidate.id, " version=", candidate.version,
+                 " lastLocked=", candidate.lastLocked, " bytes=", candidate.usage.bytes);
+            Journal::ScopedEntry journalEntry{*journal, Journal::Operation::UNINSTALL, candidate.id, candidate.version};
+            auto locations = dataBase->GetAppsLocations(candidate.type, candidate.id, candidate.version);
+            // app data is kept, like for an uninstall with uninstallType 'upgrade'
+            dataBase->RemoveInstalledApp(candidate.type, candidate.id, candidate.version);
+            for (const auto &location : locations)
+            {
+                std::string appPath;
+                if (resolveAppPath(location, appPath))
+                {
+                    // synchronously, the space is needed by the install that follows
+                    Filesystem::removeDirectory(appPath);
+                }
+            }
+            evicted = true;
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::evict] Unable to evict id=", candidate.id, " version=", candidate.version, ": ", error.what());
+        }
+        lockedApps.unblock(candidate.id, candidate.version);
+        return evicted;
+    }
+
+    bool Executor::resolveAppPath(const DataStorage::AppLocation &location, std::string &appPath) const
+    {
+        const AppVolume *volume = config.findAppVolume(location.volume);
+        if (!volume)
+        {
+            ERROR("[Executor::resolveAppPath] Unknown app volume '", location.volume, "'");
+            return false;
+        }
+        appPath = volume->path + location.path;
+        return true;
+    }
+
+    TrashReaper *Executor::reaperFor(const std::string &path) const
+    {
+        // longest matching volume root, the trash has to be on the same filesystem
+        TrashReaper *reaper{nullptr};
+        std::size_t matched{0};
+        const auto &volumes = config.getAppVolumes();
+        for (std::size_t i = 0; i < volumes.size() && i < reapers.size(); ++i)
+        {
+            if (path.compare(0, volumes[i].path.size(), volumes[i].path) == 0 && volumes[i].path.size() > matched)
+            {
+                reaper = reapers[i].get();
+                matched = volumes[i].path.size();
+            }
+        }
+        return reaper;
+    }
+
+    void Executor::clearTmp()
+    {
+        // leftovers of interrupted installs are only staging directories
+        for (const auto &volume : availableVolumes())
+        {
+            removeInBackground(volume.tmpPath, APPS_TMP_DIR_NAME);
+            Filesystem::createDirectory(volume.tmpPath);
+        }
+    }
+
+    void Executor::startAppsWatcher()
+    {
+        appsWatcher.reset();
+        if (config.getWatchAppsPath())
+        {
+            // appspath only, additional volumes are still scanned
+            appsWatcher = std::make_unique<AppsWatcher>(config.getAppsPath() + Filesystem::LISA_EPOCH + '/');
+            if (!appsWatcher->start())
+            {
+                WARNING("[Executor::startAppsWatcher] Falling back to scanning ", config.getAppsPath());
+                appsWatcher.reset();
+            }
+        }
+    }
+
+    void Executor::initializeDataBase(const std::string &dbPath, DataStorage::IntegrityCheck check)
+    {
+        std::string path = dbPath + Filesystem::LISA_EPOCH + '/';
+        Filesystem::ScopedDir dbDir(path);
+        // generations are only comparable within one storage
+        std::atomic_store(&snapshot, std::shared_ptr<const CatalogSnapshot>{});
+        dataBase = std::make_unique<packagemanager::SqlDataStorage>(path, config.getDatabaseProfile());
+        dataBase->Initialize(check);
+        dbDir.commit();
+        INFO("[Executor::initializeDataBase] Database created");
+    }
+
+    bool Executor::openJournal(std::vector<Journal::Entry> &incomplete, bool &cleanShutdown)
+    {
+        std::string path = config.getDatabasePath() + Filesystem::LISA_EPOCH + '/';
+        Filesystem::createDirectory(path);
+        journal = std::make_unique<Journal>(path + "journal");
+        return journal->open(incomplete, cleanShutdown);
+    }
+
+    void Executor::recover(const std::vector<Journal::Entry> &incomplete, bool fullMaintenance)
+    {
+        if (fullMaintenance)
+        {
+            // first start, upgrade from a version without journal or a lost catalog
+            INFO("[Executor::recover] No usable journal, running full maintenance");
+            doMaintenance();
+            for (const auto &volume : availableVolumes())
+            {
+                repairPermissions(volume.path);
+            }
+        }
+        else
+        {
+            INFO("[Executor::recover] Journal found, ", incomplete.size(), " interrupted operations");
+            for (const auto &entry : incomplete)
+            {
+                recoverOperation(entry);
+            }
+            // interrupted installs only ever leave staging directories behind
+            clearTmp();
+        }
+        journal->reset();
+    }
+
+    void Executor::runDeferredStartup(bool fullMaintenance)
+    {
+        ScopedThreadPriority scopedPriority{config.getBackgroundPriority()};
+        auto start = std::chrono::steady_clock::now();
+        if (fullMaintenance)
+        {
+            LockGuard lock(taskMutex);
+            doMaintenance();
+            for (const auto &volume : availableVolumes())
+            {
+                repairPermissions(volume.path);
+            }
+            journal->reset();
+        }
+
+        if (!dataBase->CheckIntegrity())
+        {
+            // the catalog is validated (and dropped if broken) on the next start
+            ERROR("[Executor::runDeferredStartup] Database integrity check failed");
+            journal->markDirty();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        INFO("[Executor::runDeferredStartup] deferred startup checks done in ", elapsed.count(), " ms");
+    }
+
+    const PriorityProfile &Executor::profileFor(JobPriority priority) const
+    {
+        return priority == JobPriority::FOREGROUND ? CALLER_PRIORITY : config.getBackgroundPriority();
+    }
+
+    void Executor::repairPermissions(const std::string &path)
+    {
+#if LISA_APPS_GID
+        try
+        {
+            Filesystem::setPermissionsRecursively(path, LISA_APPS_GID, false);
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::repairPermissions] ", error.what());
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    void Executor::waitForBackgroundTasks()
+    {
+        if (backgroundThread.joinable())
+        {
+            backgroundThread.join();
+        }
+    }
+
+    void Executor::recoverOperation(const Journal::Entry &entry)
+    {
+        bool isInstall = entry.operation == Journal::Operation::INSTALL;
+        INFO("[Executor::recoverOperation] Interrupted ", isInstall ? "install" : "uninstall", " of id=", entry.id, " version=", entry.version);
+
+        try
+        {
+            auto locations = dataBase->GetAppsLocations("", entry.id, entry.version);
+            bool installed = !locations.empty();
+
+            std::string appPath;
+            if (isInstall && installed && resolveAppPath(locations.front(), appPath) &&
+                Filesystem::directoryExists(appPath) && !Filesystem::isEmpty(appPath))
+            {
+                // published and committed, only the journal record was missing
+                getAppUsage("", entry.id, entry.version, appPath);
+                repairPermissions(appPath);
+                return;
+            }
+
+            // roll back an install that did not finish, roll forward an uninstall
+            if (installed)
+            {
+                dataBase->RemoveInstalledApp(dataBase->GetTypeOfApp(entry.id), entry.id, entry.version);
+            }
+            // the catalog row may be gone already, the directory can be on any volume
+            auto appSubPath = Filesystem::createAppPath(entry.id, entry.version);
+            for (const auto &volume : availableVolumes())
+            {
+                removeInBackground(volume.path + appSubPath, entry.id + '_' + entry.version);
+            }
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::recoverOperation] Unable to recover: ", error.what());
+        }
+    }
+
+    Executor::InstalledState Executor::verifyInstalled(const std::string &id,
+                                                       const std::string &version,
+                                                       const std::string &url,
+                                                       ReinstallCheck check)
+    {
+        try
+        {
+            auto locations = dataBase->GetAppsLocations("", id, version);
+            if (locations.empty())
+            {
+                return InstalledState::DAMAGED;
+            }
+            const auto &location = locations.front();
+            const AppVolume *volume = config.findAppVolume(location.volume);
+            if (!volume || !isVolumeAvailable(*volume))
+            {
+                // kept as it is until the volume is back, like maintenance does
+                WARNING("[Executor::verifyInstalled] app volume '", location.volume, "' not available");
+                return InstalledState::UNAVAILABLE;
+            }
+
+            auto appPath = volume->path + location.path;
+            auto hibernatedArchive = hibernatedBasePath(*volume, id, version) + HIBERNATED_ARCHIVE_SUFFIX;
+            bool present = location.hibernated ? fileExists(hibernatedArchive)
+                                               : Filesystem::directoryExists(appPath) && !Filesystem::isEmpty(appPath);
+            if (!present || check == ReinstallCheck::CATALOG)
+            {
+                return present ? InstalledState::INTACT : InstalledState::DAMAGED;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto expected = Archive::getContentDigest(url);
+            auto installed = location.hibernated ? Archive::getContentDigest(hibernatedArchive) : Filesystem::getTreeDigest(appPath);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            INFO("[Executor::verifyInstalled] id=", id, " version=", version, " content verified in ", elapsed.count(), " ms");
+            return !expected.empty() && expected == installed ? InstalledState::INTACT : InstalledState::DAMAGED;
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::verifyInstalled] ", error.what());
+            return InstalledState::DAMAGED;
+        }
+    }
+
+    bool Executor::isAppInstalled(const std::string &type,
+                                  const std::string &id,
+                                  const std::string &version)
+    {
+        auto appInstalled{false};
+        try
+        {
+            auto catalog = GetCatalogSnapshot();
+            auto row = catalog->find(id, version);
+            appInstalled = row != CatalogSnapshot::npos && (type.empty() || (*catalog)[row].type == type);
+        }
+        catch (std::exception &exc)
+        {
+            ERROR("[Executor::isAppInstalled] error while checking if app installed: ", exc.what());
+        }
+        return appInstalled;
+    }
+
+    void Executor::importAnnotations(const std::string &type,
+                                     const std::string &id,
+                                     const std::string &version,
+                                     const std::string &appPath)
+    {
+        if (config.getAnnotationsFile().empty())
+        {
+            return;
+        }
+
+        boost::filesystem::path filepath = appPath;
+        filepath /= config.getAnnotationsFile();
+        std::ifstream file(filepath.string());
+        if (!file.good())
+        {
+            return;
+        }
+
+        if (!file.is_open())
+        {
+            ERROR("[Executor::importAnnotations] Failed to open ", filepath.string());
+            return;
+        }
+
+        INFO("[Executor::importAnnotations] Auto importing annotations from ", filepath.string());
+        try
         {
             boost::property_tree::ptree pt;
             boost::property_tree::read_json(file, pt);
@@ -505,6 +1320,7 @@ namespace packagemanager
             if (pt.count("annotations") > 0)
             {
                 std::regex pattern(config.getAnnotationsRegex());
+                DataStorage::MetadataValues values;
                 for (const auto &kvp : pt.get_child("annotations"))
                 {
                     auto &key = kvp.first;
@@ -513,16 +1329,18 @@ namespace packagemanager
                     if (std::regex_search(key, pattern))
                     {
                         DEBUG("[Executor::importAnnotations] Importing ", key, " = ", value, " as metadata");
-                        try
-                        {
-                            dataBase->SetMetadata(type, id, version, key, value);
-                        }
-                        catch (std::exception &error)
-                        {
-                            ERROR("[Executor::importAnnotations] Unable to save metadata: ", error.what());
-                        }
+                        values.emplace_back(key, value);
                     }
                 }
+
+                try
+                {
+                    dataBase->SetMetadata(type, id, version, values);
+                }
+                catch (std::exception &error)
+                {
+                    ERROR("[Executor::importAnnotations] Unable to save metadata: ", error.what());
+                }
             }
         }
         catch (std::exception &error)
@@ -536,43 +1354,299 @@ namespace packagemanager
                            std::string version,
                            std::string url,
                            std::string appName,
-                           std::string category)
+                           std::string category,
+                           UsageHint hint,
+                           const std::string &digest,
+                           JobPriority priority)
     {
         DEBUG("[Executor::extract] url=", url, " appName=", appName, " cat=", category);
 
         auto appSubPath = Filesystem::createAppPath(id, version);
         DEBUG("[Executor::extract] appSubPath: ", appSubPath);
 
-        auto tmpPath = config.getAppsTmpPath();
-        auto tmpDirPath = tmpPath + appSubPath;
-        Filesystem::ScopedDir scopedTmpDir{tmpDirPath};
+        auto requiredBytes = Archive::getUnpackedSizeEstimate(url);
+        const AppVolume *chosenVolume = chooseVolume(hint, requiredBytes);
+        if (!chosenVolume && config.getEvictionPolicy() == EvictionPolicy::LRU)
+        {
+            std::vector<DataStorage::EvictionCandidate> plan;
+            if (planEviction(hint, requiredBytes, plan))
+            {
+                for (const auto &candidate : plan)
+                {
+                    evict(candidate);
+                }
+                chosenVolume = chooseVolume(hint, requiredBytes);
+            }
+        }
+        if (!chosenVolume)
+        {
+            ERROR("[Executor::extract] No app volume with ", requiredBytes, " bytes available");
+            return false;
+        }
+        const AppVolume volume = *chosenVolume;
+        INFO("[Executor::extract] Installing to ", volume.path);
+
+        // committed on every way out, leftovers of a failed install are removed by the scoped dirs
+        Journal::ScopedEntry journalEntry{*journal, Journal::Operation::INSTALL, id, version};
+
+        // Extraction happens in a staging directory below tmp, on the same filesystem
+        // as the apps. It is never committed: after publishing only its empty parents
+        // are left for the ScopedDir to clean up, after a crash tmp is simply dropped.
+        auto stagingPath = volume.tmpPath + appSubPath;
+        Filesystem::ScopedDir scopedStagingDir{stagingPath};
 
         // The full file path to the dowloaded app archive is passes as url.
         auto tmpFilePath = url;
 
-        const std::string appsPath = config.getAppsPath() + appSubPath;
-        DEBUG("[Executor::extract] creating ", appsPath);
-        Filesystem::ScopedDir scopedAppDir{appsPath};
+        DEBUG("[Executor::extract] Extracting ", tmpFilePath, " to ", stagingPath);
+        std::vector<Filesystem::FileUsage> manifest;
+#if LISA_APPS_GID
+        // owner and mode are set while extracting, no recursive fix-up is needed afterwards
+        Archive::Ownership ownership{static_cast<int>(getuid()), LISA_APPS_GID, false};
+        const Archive::Ownership *appOwnership = &ownership;
+#else
+        const Archive::Ownership *appOwnership = nullptr;
+#endif
+        // a background install yields to launches between archive entries
+        IoScheduler::BackgroundJob job{scheduler};
+        std::function<void()> betweenEntries;
+        if (priority == JobPriority::BACKGROUND)
+        {
+            betweenEntries = [&job]() { job.checkpoint(); };
+        }
+        auto unpacked = Archive::unpackArchive(tmpFilePath, stagingPath, &manifest, appOwnership, betweenEntries);
+        if (job.pauses())
+        {
+            INFO("[Executor::extract] id=", id, " version=", version, " paused ", job.pauses(),
+                 " times for ", job.paused().count(), " ms");
+        }
+        if (!unpacked)
+        {
+            ERROR("[Executor::extract] Unable to extract ", tmpFilePath);
+            return false;
+        }
 
-        DEBUG("[Executor::extract] Extracting ", tmpFilePath, "to ", appsPath);
-        bool response = Archive::unpackArchive(tmpFilePath, appsPath);
+        const std::string appsPath = volume.path + appSubPath;
+        const std::string appsParentPath = volume.path + Filesystem::createAppPath(id);
+        Filesystem::ScopedDir scopedAppParentDir{appsParentPath};
+
+#if LISA_APPS_GID
+        Filesystem::setPermission(stagingPath, getuid(), LISA_APPS_GID, true, false);
+        Filesystem::setPermission(appsParentPath, getuid(), LISA_APPS_GID, true, false);
+#endif
+
+        DEBUG("[Executor::extract] publishing ", appsPath);
+        Filesystem::publishDirectory(stagingPath, appsPath);
 
         auto appStorageSubPath = Filesystem::createAppPath(id);
+        try
+        {
+            // the whole install is recorded in one commit, a crash leaves either all of it or nothing
+            auto transaction = dataBase->BeginTransaction();
+
+            // We are passing empty URL as we are no longer downloading the app
+            //  from the URL, but rather unpacking it from the tmp directory.
+            dataBase->AddInstalledApp(type, id, version, "", appName, category, appSubPath, appStorageSubPath, volume.name);
+            dataBase->SetAppUsage(type, id, version, manifest);
+            if (!digest.empty())
+            {
+                dataBase->SetArchiveDigest(id, version, digest);
+            }
+            // a fresh install counts as used, it is neither evicted nor hibernated first
+            dataBase->SetLastLocked(id, version, std::time(nullptr));
 
-        // We are passing empty URL as we are no longer downloading the app
-        //  from the URL, but rather unpacking it from the tmp directory.
-        dataBase->AddInstalledApp(type, id, version, "", appName, category, appSubPath, appStorageSubPath);
+            // auto-import annotations as metadata
+            importAnnotations(type, id, version, appsPath);
 
-        // everything went fine, mark app directories to not be removed
-        scopedAppDir.commit();
+            transaction->commit();
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::extract] Unable to record installed app: ", error.what());
+            removeInBackground(appsPath, id + '_' + version);
+            return false;
+        }
 
-        // auto-import annotations as metadata
-        importAnnotations(type, id, version, appsPath);
+        // everything went fine, mark app directories to not be removed
+        scopedAppParentDir.commit();
 
         doMaintenance();
 
         DEBUG("[Executor::extract] finished");
-        return response;
+        return true;
+    }
+
+    bool Executor::hibernate(const DataStorage::HibernationCandidate &candidate)
+    {
+        const auto &id = candidate.id;
+        const auto &version = candidate.version;
+
+        // the candidate list is not taken under taskMutex, the version may be gone or hibernated already
+        auto locations = dataBase->GetAppsLocations(candidate.type, id, version);
+        if (locations.empty() || locations.front().hibernated)
+        {
+            return false;
+        }
+        const auto &location = locations.front();
+        const AppVolume *volume = config.findAppVolume(location.volume);
+        if (!volume || !isVolumeAvailable(*volume))
+        {
+            return false;
+        }
+        auto appPath = volume->path + location.path;
+        auto basePath = hibernatedBasePath(*volume, id, version);
+        auto archivePath = basePath + HIBERNATED_ARCHIVE_SUFFIX;
+        auto partPath = archivePath + ".part";
+
+        auto start = std::chrono::steady_clock::now();
+        Filesystem::createDirectory(volume->hibernatedPath);
+        IoScheduler::BackgroundJob job{scheduler};
+        auto packed = Archive::packArchive(appPath, partPath, HIBERNATION_COMPRESSION_LEVEL,
+                                           [&job]() { job.checkpoint(); });
+        if (job.pauses())
+        {
+            INFO("[Executor::hibernate] id=", id, " version=", version, " paused ", job.pauses(),
+                 " times for ", job.paused().count(), " ms");
+        }
+        if (!packed)
+        {
+            ERROR("[Executor::hibernate] Unable to pack ", appPath);
+            removeFile(partPath);
+            return false;
+        }
+        // the annotations file stays readable for the app metadata without rehydrating
+        bool annotationsCopied{true};
+        auto annotationsPath = appPath + "/" + config.getAnnotationsFile();
+        if (fileExists(annotationsPath))
+        {
+            std::ifstream source(annotationsPath, std::ios::binary);
+            std::ofstream copy(basePath + HIBERNATED_ANNOTATIONS_SUFFIX, std::ios::binary | std::ios::trunc);
+            annotationsCopied = static_cast<bool>(copy << source.rdbuf());
+        }
+        if (!annotationsCopied || std::rename(partPath.c_str(), archivePath.c_str()) != 0)
+        {
+            ERROR("[Executor::hibernate] Unable to store ", archivePath);
+            removeFile(partPath);
+            removeFile(basePath + HIBERNATED_ANNOTATIONS_SUFFIX);
+            return false;
+        }
+
+        // the archive is complete, only the switch-over has to exclude a concurrent Lock
+        if (!lockedApps.blockIfUnlocked(id, version, LockRegistry::BlockReason::HIBERNATION))
+        {
+            INFO("[Executor::hibernate] id=", id, " version=", version, " was locked meanwhile");
+            removeFile(archivePath);
+            removeFile(basePath + HIBERNATED_ANNOTATIONS_SUFFIX);
+            return false;
+        }
+        bool hibernated{false};
+        try
+        {
+            dataBase->SetHibernated(id, version, true);
+            hibernated = true;
+            removeInBackground(appPath, id + '_' + version);
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::hibernate] id=", id, " version=", version, ": ", error.what());
+            if (!hibernated)
+            {
+                removeFile(archivePath);
+                removeFile(basePath + HIBERNATED_ANNOTATIONS_SUFFIX);
+            }
+        }
+        lockedApps.unblock(id, version);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        INFO("[Executor::hibernate] id=", id, " version=", version, " unused since ", candidate.lastLocked,
+             " packed in ", elapsed.count(), " ms");
+        return hibernated;
+    }
+
+    bool Executor::rehydrate(const std::string &id, const std::string &version)
+    {
+        auto locations = dataBase->GetAppsLocations("", id, version);
+        if (locations.empty() || !locations.front().hibernated)
+        {
+            return true;
+        }
+
+        LockGuard lock(taskMutex);
+        // re-checked, a concurrent Lock may have rehydrated it already
+        locations = dataBase->GetAppsLocations("", id, version);
+        if (locations.empty() || !locations.front().hibernated)
+        {
+            return !locations.empty();
+        }
+        const auto &location = locations.front();
+        const AppVolume *volume = config.findAppVolume(location.volume);
+        if (!volume || !isVolumeAvailable(*volume))
+        {
+            ERROR("[Executor::rehydrate] App volume '", location.volume, "' not available");
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto basePath = hibernatedBasePath(*volume, id, version);
+        auto archivePath = basePath + HIBERNATED_ARCHIVE_SUFFIX;
+
+        // same staging and publishing as extract
+        auto stagingPath = volume->tmpPath + location.path;
+        Filesystem::ScopedDir scopedStagingDir{stagingPath};
+#if LISA_APPS_GID
+        Archive::Ownership ownership{static_cast<int>(getuid()), LISA_APPS_GID, false};
+        const Archive::Ownership *appOwnership = &ownership;
+#else
+        const Archive::Ownership *appOwnership = nullptr;
+#endif
+        if (!Archive::unpackArchive(archivePath, stagingPath, nullptr, appOwnership))
+        {
+            ERROR("[Executor::rehydrate] Unable to unpack ", archivePath);
+            return false;
+        }
+
+        const std::string appPath = volume->path + location.path;
+        const std::string appParentPath = volume->path + Filesystem::createAppPath(id);
+        Filesystem::ScopedDir scopedAppParentDir{appParentPath};
+#if LISA_APPS_GID
+        Filesystem::setPermission(stagingPath, getuid(), LISA_APPS_GID, true, false);
+        Filesystem::setPermission(appParentPath, getuid(), LISA_APPS_GID, true, false);
+#endif
+        try
+        {
+            Filesystem::publishDirectory(stagingPath, appPath);
+            scopedAppParentDir.commit();
+            dataBase->SetHibernated(id, version, false);
+        }
+        catch (std::exception &error)
+        {
+            // a published tree with the flag still set is picked up by maintenance
+            ERROR("[Executor::rehydrate] ", error.what());
+            return false;
+        }
+        removeFile(archivePath);
+        removeFile(basePath + HIBERNATED_ANNOTATIONS_SUFFIX);
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        try
+        {
+            dataBase->SetRehydrationTime(id, version, elapsed);
+        }
+        catch (std::exception &error)
+        {
+            WARNING("[Executor::rehydrate] Unable to record rehydration time: ", error.what());
+        }
+        auto maxRehydrationTime = config.getMaxRehydrationTime();
+        if (maxRehydrationTime && static_cast<unsigned long long>(elapsed) > maxRehydrationTime)
+        {
+            WARNING("[Executor::rehydrate] id=", id, " version=", version, " took ", elapsed,
+                    " ms, more than ", maxRehydrationTime, " ms, it is no longer hibernated");
+        }
+        else
+        {
+            INFO("[Executor::rehydrate] id=", id, " version=", version, " rehydrated in ", elapsed, " ms");
+        }
+        return true;
     }
 
     void Executor::doUninstall(std::string type, std::string id, std::string version, std::string uninstallType)
@@ -581,19 +1655,47 @@ namespace packagemanager
 
         if (!version.empty())
         {
-            dataBase->RemoveInstalledApp(type, id, version);
+            Journal::ScopedEntry journalEntry{*journal, Journal::Operation::UNINSTALL, id, version};
 
-            auto appSubPath = Filesystem::createAppPath(id, version);
-            auto appPath = config.getAppsPath() + appSubPath;
+            auto locations = dataBase->GetAppsLocations(type, id, version);
+            dataBase->RemoveInstalledApp(type, id, version);
 
-            DEBUG("[Executor::doUninstall] removing ", appPath);
-            Filesystem::removeDirectory(appPath);
+            for (const auto &location : locations)
+            {
+                std::string appPath;
+                if (resolveAppPath(location, appPath))
+                {
+                    DEBUG("[Executor::doUninstall] removing ", appPath);
+                    removeInBackground(appPath, id + '_' + version);
+                }
+            }
         }
 
         doMaintenance();
 
         DEBUG("[Executor::doUninstall] finished");
     }
+    void Executor::removeInBackground(const std::string &path, const std::string &name)
+    {
+        if (auto *reaper = reaperFor(path))
+        {
+            try
+            {
+                // rename is atomic, the expensive unlinking happens outside of taskMutex
+                if (Filesystem::moveDirectory(path, reaper->createTrashPath(name)))
+                {
+                    reaper->wakeUp();
+                }
+                return;
+            }
+            catch (Filesystem::FilesystemError &error)
+            {
+                WARNING("[Executor::removeInBackground] ", error.what(), ", removing synchronously");
+            }
+        }
+        Filesystem::removeDirectory(path);
+    }
+
     uint32_t Executor::GetAppInstalledPath(const std::string &id,
                                            const std::string &version, std::string &appPath) const
     {
@@ -603,11 +1705,11 @@ namespace packagemanager
             ERROR("GetAppInstalledPath: id or version is empty");
             return RETURN_ERROR;
         }
-        std::vector<std::string> path = dataBase->GetAppsPaths("", id, version);
+        auto catalog = GetCatalogSnapshot();
+        auto row = catalog->find(id, version);
 
-        if (!path.empty())
+        if (row != CatalogSnapshot::npos && resolveAppPath((*catalog)[row].location(), appPath))
         {
-            appPath = config.getAppsPath() + path[0];
             DEBUG("GetAppInstalledPath: appPath=", appPath);
         }
         else
@@ -626,55 +1728,150 @@ namespace packagemanager
 
         return boost::filesystem::exists(appPath) ? RETURN_SUCCESS : RETURN_ERROR;
     }
+    uint32_t Executor::GetAppAnnotationsPath(const std::string &id,
+                                             const std::string &version,
+                                             std::string &annotationsPath) const
+    {
+        auto catalog = GetCatalogSnapshot();
+        auto row = catalog->find(id, version);
+        if (row == CatalogSnapshot::npos)
+        {
+            return RETURN_ERROR;
+        }
+        annotationsPath = this->annotationsPath((*catalog)[row].location(), id, version);
+        return annotationsPath.empty() ? RETURN_ERROR : RETURN_SUCCESS;
+    }
+
+    std::string Executor::annotationsPath(const DataStorage::AppLocation &location, const std::string &id, const std::string &version) const
+    {
+        const AppVolume *volume = config.findAppVolume(location.volume);
+        if (!volume)
+        {
+            return {};
+        }
+        auto path = location.hibernated ? hibernatedBasePath(*volume, id, version) + HIBERNATED_ANNOTATIONS_SUFFIX
+                                        : volume->path + location.path + "/" + config.getAnnotationsFile();
+        return fileExists(path) ? path : std::string{};
+    }
+
+    uint32_t Executor::GetInstalledApps(std::vector<InstalledAppPaths> &apps) const
+    {
+        try
+        {
+            apps.clear();
+            for (const auto &app : dataBase->GetInstalledApps())
+            {
+                InstalledAppPaths paths{app.details, {}, annotationsPath(app.location, app.details.id, app.details.version)};
+                resolveAppPath(app.location, paths.appPath);
+                apps.push_back(std::move(paths));
+            }
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[Executor::GetInstalledApps] Unable to retrieve installed apps: ", error.what());
+            return RETURN_ERROR;
+        }
+        return RETURN_SUCCESS;
+    }
+
     void Executor::doMaintenance()
     {
         try
         {
-            // clear tmp
-            Filesystem::removeDirectory(config.getAppsTmpPath());
-            Filesystem::createDirectory(config.getAppsTmpPath());
+            clearTmp();
+
+            // one catalog query for the whole pass instead of one per directory and app
+            auto installedApps = dataBase->GetInstalledApps();
+            std::set<std::tuple<std::string, std::string, std::string>> installedDirs;
+            for (const auto &app : installedApps)
+            {
+                installedDirs.emplace(app.location.volume, app.details.id, app.details.version);
+            }
 
             // remove installed apps data not present in installed_apps
-            auto appsPathRoot = config.getAppsPath() + Filesystem::LISA_EPOCH + '/';
-            auto foundApps = scanDirectories(appsPathRoot, false);
-            for (const auto &app : foundApps)
+            for (const auto &volume : availableVolumes())
             {
-                DEBUG(app);
-                if (!dataBase->IsAppInstalled("", app.id, app.version))
+                auto appsPathRoot = volume.path + Filesystem::LISA_EPOCH + '/';
+                bool watched = appsWatcher && volume.name.empty();
+                auto foundApps = watched ? watchedDirectories(*appsWatcher, appsPathRoot) : scanDirectories(appsPathRoot, false);
+                for (const auto &app : foundApps)
                 {
-                    ERROR(app, " not found in installed apps, removing dir");
-                    auto path = config.getAppsPath() + Filesystem::createAppPath(app.id, app.version);
-                    Filesystem::removeDirectory(path);
+                    DEBUG(app);
+                    if (!installedDirs.count(std::make_tuple(volume.name, app.id, app.version)))
+                    {
+                        ERROR(app, " not found in installed apps, removing dir");
+                        auto path = volume.path + Filesystem::createAppPath(app.id, app.version);
+                        removeInBackground(path, app.id + '_' + app.version);
+                    }
                 }
             }
 
-            auto appsDetailsList = dataBase->GetAppDetailsListOuterJoin();
-            for (const auto &details : appsDetailsList)
+            std::set<std::string> hibernatedFiles;
+            for (const auto &app : installedApps)
             {
+                const auto &details = app.details;
+                const auto &location = app.location;
                 DEBUG("details: ", details.id, ":", details.version);
-
-                auto appPaths = dataBase->GetAppsPaths(details.type, details.id, details.version);
-
-                DEBUG("PATHS APPS:");
-                for (const auto &path : appPaths)
+                DEBUG("path: ", location.path);
+                const AppVolume *volume = config.findAppVolume(location.volume);
+                if (!volume || !isVolumeAvailable(*volume))
                 {
-                    DEBUG("path: ", path);
-                    auto appPath = config.getAppsPath() + path;
-                    DEBUG("abs path: ", appPath);
+                    // kept until the volume is attached (or configured) again
+                    DEBUG("volume '", location.volume, "' not available");
+                    continue;
+                }
+                auto appPath = volume->path + location.path;
+                DEBUG("abs path: ", appPath);
 
-                    bool noAppFiles = Filesystem::directoryExists(appPath) ? Filesystem::isEmpty(appPath) : true;
-                    if (noAppFiles)
+                bool appFilesPresent = Filesystem::directoryExists(appPath) && !Filesystem::isEmpty(appPath);
+                if (location.hibernated)
+                {
+                    auto basePath = hibernatedBasePath(*volume, details.id, details.version);
+                    if (appFilesPresent)
                     {
+                        // interrupted after publishing a rehydrated app, or before removing a hibernated one
+                        dataBase->SetHibernated(details.id, details.version, false);
+                        removeFile(basePath + HIBERNATED_ANNOTATIONS_SUFFIX);
+                        removeFile(basePath + HIBERNATED_ARCHIVE_SUFFIX);
+                    }
+                    else if (!fileExists(basePath + HIBERNATED_ARCHIVE_SUFFIX))
+                    {
+                        ERROR("[Executor::doMaintenance] hibernated archive of ", details.id, ":", details.version, " missing");
                         dataBase->RemoveInstalledApp(details.type, details.id, details.version);
                     }
+                    else
+                    {
+                        hibernatedFiles.insert(basePath + HIBERNATED_ARCHIVE_SUFFIX);
+                        hibernatedFiles.insert(basePath + HIBERNATED_ANNOTATIONS_SUFFIX);
+                    }
+                    continue;
                 }
 
-                auto dataPaths = dataBase->GetDataPaths(details.type, details.id);
+                bool noAppFiles = Filesystem::directoryExists(appPath) ? Filesystem::isEmpty(appPath) : true;
+                if (noAppFiles)
+                {
+                    dataBase->RemoveInstalledApp(details.type, details.id, details.version);
+                }
+                else if (!app.usageRecorded)
+                {
+                    getAppUsage(details.type, details.id, details.version, appPath);
+                }
             }
 
-#if LISA_APPS_GID
-            Filesystem::setPermissionsRecursively(config.getAppsPath(), LISA_APPS_GID, false);
-#endif
+            // archives of uninstalled versions and of interrupted hibernations
+            for (const auto &volume : availableVolumes())
+            {
+                boost::system::error_code ec;
+                for (boost::filesystem::directory_iterator it(volume.hibernatedPath, ec), end; !ec && it != end; it.increment(ec))
+                {
+                    auto path = it->path().string();
+                    if (!hibernatedFiles.count(path))
+                    {
+                        DEBUG("[Executor::doMaintenance] removing ", path);
+                        removeFile(path);
+                    }
+                }
+            }
         }
         catch (std::exception &exc)
         {
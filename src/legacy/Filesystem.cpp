@@ -19,10 +19,26 @@
 
 #include "Filesystem.h"
 #include "Debug.h"
+#include "Digest.h"
+#include "TreeWalker.h"
 
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <map>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
 namespace packagemanager
 {
     namespace Filesystem
@@ -40,6 +56,60 @@ namespace packagemanager
                 std::replace_if(str.begin(), str.end(), isNotPosixCompatibile, '_');
             }
 
+            // Removes all entries below the directory referred to by dirFd, dirFd itself stays open
+            bool removeEntriesAt(int dirFd, const std::atomic<bool> *cancel)
+            {
+                int iterFd = dup(dirFd);
+                DIR *dir = iterFd < 0 ? nullptr : fdopendir(iterFd);
+                if (!dir)
+                {
+                    if (iterFd >= 0)
+                    {
+                        close(iterFd);
+                    }
+                    return false;
+                }
+
+                bool complete{true};
+                struct dirent *entry{};
+                while ((entry = readdir(dir)) != nullptr)
+                {
+                    if (cancel && cancel->load())
+                    {
+                        complete = false;
+                        break;
+                    }
+                    if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+                    {
+                        continue;
+                    }
+
+                    bool isDir = entry->d_type == DT_DIR;
+                    if (entry->d_type == DT_UNKNOWN)
+                    {
+                        struct stat st{};
+                        isDir = fstatat(dirFd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+                    }
+
+                    if (isDir)
+                    {
+                        int childFd = openat(dirFd, entry->d_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+                        if (childFd >= 0)
+                        {
+                            complete = removeEntriesAt(childFd, cancel) && complete;
+                            close(childFd);
+                        }
+                    }
+                    if (unlinkat(dirFd, entry->d_name, isDir ? AT_REMOVEDIR : 0) != 0 && errno != ENOENT)
+                    {
+                        ERROR("Could not remove ", entry->d_name, " error: ", strerror(errno));
+                        complete = false;
+                    }
+                }
+                closedir(dir);
+                return complete;
+            }
+
         } // namespace anonymous
 
         bool isAcceptableFilePath(const std::string &pathPart)
@@ -165,27 +235,79 @@ namespace packagemanager
         {
             DEBUG("removing directory ", path);
 
-            try
+            struct stat st{};
+            if (lstat(path.c_str(), &st) != 0)
             {
-                boost::filesystem::remove_all(path);
+                if (errno == ENOENT)
+                {
+                    return;
+                }
+                throw FilesystemError("error " + std::string(strerror(errno)) + " removing directory " + path);
             }
-            catch (boost::filesystem::filesystem_error &error)
+
+            bool removed{true};
+            if (S_ISDIR(st.st_mode))
             {
-                std::string message = std::string{} + "error " + error.what() + " removing directory " + path;
-                throw FilesystemError(message);
+                // files are unlinked in parallel while walking, the emptied directories deepest first afterwards
+                std::mutex directoriesMutex;
+                std::vector<std::string> directories;
+                auto removeFile = [&](const TreeWalker::Entry &entry)
+                {
+                    if (entry.isDirectory)
+                    {
+                        std::lock_guard<std::mutex> lock(directoriesMutex);
+                        directories.push_back(entry.parentPath + entry.name);
+                    }
+                    else if (unlinkat(entry.dirFd, entry.name, 0) != 0 && errno != ENOENT)
+                    {
+                        throw FilesystemError(std::string(entry.name) + ": " + strerror(errno));
+                    }
+                };
+                removed = TreeWalker().walk(path, removeFile);
+
+                auto depth = [](const std::string &dir)
+                {
+                    return std::count(dir.begin(), dir.end(), '/');
+                };
+                std::sort(directories.begin(), directories.end(), [&](const std::string &a, const std::string &b)
+                {
+                    return depth(a) > depth(b);
+                });
+                directories.push_back({});
+                for (const auto &dir : directories)
+                {
+                    if (rmdir((path + '/' + dir).c_str()) != 0 && errno != ENOENT)
+                    {
+                        removed = false;
+                    }
+                }
+            }
+            else if (unlink(path.c_str()) != 0 && errno != ENOENT)
+            {
+                removed = false;
+            }
+
+            if (!removed)
+            {
+                throw FilesystemError("error removing directory " + path);
             }
         }
 
         void removeAllDirectoriesExcept(const std::string &path, const std::string &except)
         {
-            DEBUG("removing directories ", path, " except ", except);
+            removeAllDirectoriesExcept(path, std::vector<std::string>{except});
+        }
+
+        void removeAllDirectoriesExcept(const std::string &path, const std::vector<std::string> &except)
+        {
+            DEBUG("removing directories ", path, " except ", except.size(), " entries");
 
             try
             {
                 boost::filesystem::directory_iterator end_itr;
                 for (boost::filesystem::directory_iterator itr(path); itr != end_itr; ++itr)
                 {
-                    if (itr->path().filename().compare(except))
+                    if (std::find(except.begin(), except.end(), itr->path().filename().string()) == except.end())
                     {
                         removeDirectory(itr->path().string());
                     }
@@ -198,6 +320,77 @@ namespace packagemanager
             }
         }
 
+        bool moveDirectory(const std::string &from, const std::string &to)
+        {
+            DEBUG("moving directory ", from, " to ", to);
+
+            if (rename(from.c_str(), to.c_str()) != 0)
+            {
+                if (errno == ENOENT)
+                {
+                    return false;
+                }
+                std::string message = std::string{} + "error " + strerror(errno) + " moving directory " + from + " to " + to;
+                throw FilesystemError(message);
+            }
+            return true;
+        }
+
+        void publishDirectory(const std::string &from, const std::string &to)
+        {
+            DEBUG("publishing directory ", from, " as ", to);
+
+            int rc{-1};
+#ifdef SYS_renameat2
+            rc = static_cast<int>(syscall(SYS_renameat2, AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), RENAME_NOREPLACE));
+#else
+            errno = ENOSYS;
+#endif
+            if (rc != 0 && (errno == ENOSYS || errno == EINVAL))
+            {
+                // kernel or filesystem without RENAME_NOREPLACE support, callers serialize installs
+                if (directoryExists(to))
+                {
+                    errno = EEXIST;
+                }
+                else
+                {
+                    rc = rename(from.c_str(), to.c_str());
+                }
+            }
+
+            if (rc != 0)
+            {
+                std::string message = std::string{} + "error " + strerror(errno) + " publishing directory " + from + " as " + to;
+                throw FilesystemError(message);
+            }
+        }
+
+        bool removeDirectoryTree(const std::string &path, const std::atomic<bool> *cancel)
+        {
+            DEBUG("removing directory tree ", path);
+
+            int dirFd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (dirFd < 0)
+            {
+                if (errno == ENOENT)
+                {
+                    return true;
+                }
+                // not a directory (or a symlink to one), plain unlink is enough
+                return unlink(path.c_str()) == 0 || errno == ENOENT;
+            }
+
+            bool complete = removeEntriesAt(dirFd, cancel);
+            close(dirFd);
+            if (complete && rmdir(path.c_str()) != 0 && errno != ENOENT)
+            {
+                ERROR("Could not remove ", path, " error: ", strerror(errno));
+                complete = false;
+            }
+            return complete;
+        }
+
         std::vector<std::string> getSubdirectories(const std::string &path)
         {
             DEBUG("path: ", path);
@@ -223,6 +416,20 @@ namespace packagemanager
             return result;
         }
 
+        unsigned int permissionMode(bool isdir, bool group_writeable)
+        {
+            unsigned int mode = S_IRUSR | S_IWUSR | S_IRGRP;
+            if (isdir)
+            {
+                mode |= S_IXUSR | S_IXGRP;
+            }
+            if (group_writeable)
+            {
+                mode |= S_IWGRP;
+            }
+            return mode;
+        }
+
         void setPermission(const std::string &path, int uid, int gid, bool isdir, bool group_writeable)
         {
             if (chown(path.c_str(), uid, gid))
@@ -232,16 +439,7 @@ namespace packagemanager
 
             try
             {
-                auto perms = boost::filesystem::owner_read | boost::filesystem::owner_write | boost::filesystem::group_read;
-                if (isdir)
-                {
-                    perms |= boost::filesystem::owner_exe;
-                    perms |= boost::filesystem::group_exe;
-                }
-                if (group_writeable)
-                {
-                    perms |= boost::filesystem::group_write;
-                }
+                auto perms = static_cast<boost::filesystem::perms>(permissionMode(isdir, group_writeable));
                 boost::filesystem::permissions(path, perms);
             }
             catch (boost::filesystem::filesystem_error &error)
@@ -256,19 +454,23 @@ namespace packagemanager
 
             int uid = getuid();
             setPermission(path, uid, gid, true, writeable);
-            try
+
+            // relative to the open parent and without following symlinks, the links themselves are only chowned
+            auto setEntryPermission = [&](const TreeWalker::Entry &entry)
             {
-                namespace bfs = boost::filesystem;
-                bfs::recursive_directory_iterator endItr;
-                for (bfs::recursive_directory_iterator itr(path); itr != endItr; ++itr)
+                if (fchownat(entry.dirFd, entry.name, uid, gid, AT_SYMLINK_NOFOLLOW))
                 {
-                    setPermission(itr->path().string(), uid, gid, bfs::is_directory(*itr), writeable);
+                    ERROR("Could not change owner of ", path, '/', entry.parentPath, entry.name);
                 }
-            }
-            catch (boost::filesystem::filesystem_error &error)
+                if (!S_ISLNK(entry.st.st_mode) &&
+                    fchmodat(entry.dirFd, entry.name, permissionMode(entry.isDirectory, writeable), 0))
+                {
+                    ERROR("Could not set permissions on ", path, '/', entry.parentPath, entry.name, " error: ", strerror(errno));
+                }
+            };
+            if (!TreeWalker().walk(path, setEntryPermission))
             {
-                std::string message = std::string{} + "error " + error.what() + " setting permissions " + path;
-                throw FilesystemError(message);
+                throw FilesystemError("error setting permissions " + path);
             }
         }
 
@@ -307,29 +509,81 @@ namespace packagemanager
             return freeSpace;
         }
 
+        DirectoryUsage getDirectoryUsage(const std::string &path)
+        {
+            std::atomic<unsigned long long> size{0};
+            std::atomic<unsigned long long> blocks{0};
+            if (directoryExists(path))
+            {
+                auto addFile = [&](const TreeWalker::Entry &entry)
+                {
+                    if (S_ISREG(entry.st.st_mode))
+                    {
+                        size += entry.st.st_size;
+                        blocks += entry.st.st_blocks;
+                    }
+                };
+                if (!TreeWalker().walk(path, addFile))
+                {
+                    throw FilesystemError("error reading directory space on " + path);
+                }
+            }
+            return DirectoryUsage{size.load(), blocks.load()};
+        }
+
         unsigned long long getDirectorySpace(const std::string &path)
         {
-            uintmax_t space{};
-            namespace bf = boost::filesystem;
-            try
+            return getDirectoryUsage(path).size;
+        }
+
+        std::vector<FileUsage> getDirectoryManifest(const std::string &path)
+        {
+            std::vector<FileUsage> manifest;
+            if (directoryExists(path))
             {
-                if (directoryExists(path))
+                std::mutex manifestMutex;
+                auto addFile = [&](const TreeWalker::Entry &entry)
                 {
-                    for (bf::recursive_directory_iterator it(path); it != bf::recursive_directory_iterator(); ++it)
+                    if (S_ISREG(entry.st.st_mode))
                     {
-                        if (bf::exists(*it) && !bf::is_directory(*it) && !bf::is_symlink(*it))
-                        {
-                            space += bf::file_size(*it);
-                        }
+                        FileUsage usage{entry.parentPath + entry.name,
+                                        static_cast<unsigned long long>(entry.st.st_size),
+                                        static_cast<unsigned long long>(entry.st.st_blocks)};
+                        std::lock_guard<std::mutex> lock(manifestMutex);
+                        manifest.push_back(std::move(usage));
                     }
+                };
+                if (!TreeWalker().walk(path, addFile))
+                {
+                    throw FilesystemError("error reading directory manifest of " + path);
                 }
+                // the walk order depends on scheduling
+                std::sort(manifest.begin(), manifest.end(), [](const FileUsage &a, const FileUsage &b)
+                {
+                    return a.path < b.path;
+                });
             }
-            catch (bf::filesystem_error &error)
+            return manifest;
+        }
+
+        std::string getTreeDigest(const std::string &path)
+        {
+            std::string root{path};
+            if (!root.empty() && root.back() != '/')
             {
-                std::string message = std::string{} + "error " + error.what() + " reading directory space on " + path;
-                throw FilesystemError(message);
+                root += '/';
+            }
+            std::map<std::string, std::string> fileDigests;
+            for (const auto &file : getDirectoryManifest(root))
+            {
+                auto digest = Digest::sha256File(root + file.path);
+                if (digest.empty())
+                {
+                    throw FilesystemError("unable to read " + root + file.path);
+                }
+                fileDigests.emplace(file.path, std::move(digest));
             }
-            return (unsigned long long)space;
+            return Digest::sha256Tree(fileDigests);
         }
 
     } // namespace Filesystem
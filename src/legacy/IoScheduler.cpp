@@ -0,0 +1,82 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IoScheduler.h"
+
+#include <algorithm>
+
+namespace packagemanager
+{
+
+    IoScheduler::BackgroundJob::BackgroundJob(IoScheduler &scheduler) : scheduler(scheduler)
+    {
+    }
+
+    void IoScheduler::BackgroundJob::checkpoint()
+    {
+        std::unique_lock<std::mutex> lock(scheduler.mutex);
+        auto start = Clock::now();
+        if (start >= scheduler.interactiveUntil || pausedTotal >= scheduler.pauseBudget)
+        {
+            return;
+        }
+
+        auto deadline = start + (scheduler.pauseBudget - pausedTotal);
+        auto now = start;
+        // the window may be extended by launches while waiting
+        while (now < scheduler.interactiveUntil && now < deadline)
+        {
+            scheduler.condition.wait_until(lock, std::min(scheduler.interactiveUntil, deadline));
+            now = Clock::now();
+        }
+        pausedTotal += now - start;
+        ++jobPauses;
+        ++scheduler.stats.pauses;
+        scheduler.stats.pausedMs += std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+    }
+
+    std::chrono::milliseconds IoScheduler::BackgroundJob::paused() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(pausedTotal);
+    }
+
+    void IoScheduler::configure(std::chrono::milliseconds window, std::chrono::milliseconds budget)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        interactiveWindow = window;
+        pauseBudget = budget;
+        // a shorter window takes effect for waiting jobs too
+        interactiveUntil = std::min(interactiveUntil, Clock::now() + interactiveWindow);
+        condition.notify_all();
+    }
+
+    void IoScheduler::noteInteractive()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.interactive;
+        interactiveUntil = std::max(interactiveUntil, Clock::now() + interactiveWindow);
+    }
+
+    IoScheduler::Stats IoScheduler::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+} // namespace packagemanager
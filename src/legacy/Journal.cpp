@@ -0,0 +1,224 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Journal.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+
+namespace packagemanager
+{
+    namespace
+    { // anonymous
+
+        // record layout, one per line:
+        //   B <sequence> <I|U> <id> <version>
+        //   C <sequence>
+        //   D
+        //   S
+        constexpr char BEGIN_RECORD = 'B';
+        constexpr char COMMIT_RECORD = 'C';
+        constexpr char DIRTY_RECORD = 'D';
+        constexpr char SHUTDOWN_RECORD = 'S';
+        constexpr char INSTALL_OPERATION = 'I';
+        constexpr char UNINSTALL_OPERATION = 'U';
+
+    } // namespace anonymous
+
+    Journal::ScopedEntry::ScopedEntry(Journal &journal, Operation operation, const std::string &id, const std::string &version)
+        : journal(journal), sequence(journal.begin(operation, id, version))
+    {
+    }
+
+    Journal::ScopedEntry::~ScopedEntry()
+    {
+        try
+        {
+            journal.commit(sequence);
+        }
+        catch (JournalError &error)
+        {
+            ERROR("[Journal::ScopedEntry] ", error.what());
+        }
+    }
+
+    Journal::Journal(const std::string &path) : path(path)
+    {
+    }
+
+    Journal::~Journal()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    bool Journal::open(std::vector<Entry> &incomplete, bool &cleanShutdown)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::ifstream file(path);
+        bool existed = file.good();
+        dirty = false;
+        cleanShutdown = false;
+
+        // a torn last line (crash while appending) simply does not parse and is skipped
+        std::map<unsigned long long, Entry> started;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream record(line);
+            char type{};
+            Entry entry{};
+            if (!(record >> type))
+            {
+                continue;
+            }
+            cleanShutdown = type == SHUTDOWN_RECORD;
+            if (type == DIRTY_RECORD)
+            {
+                dirty = true;
+            }
+            if (!(record >> entry.sequence))
+            {
+                continue;
+            }
+            lastSequence = std::max(lastSequence, entry.sequence);
+
+            char operation{};
+            if (type == BEGIN_RECORD && record >> operation >> entry.id >> entry.version)
+            {
+                entry.operation = operation == UNINSTALL_OPERATION ? Operation::UNINSTALL : Operation::INSTALL;
+                started[entry.sequence] = entry;
+            }
+            else if (type == COMMIT_RECORD)
+            {
+                started.erase(entry.sequence);
+            }
+        }
+
+        incomplete.clear();
+        for (const auto &entry : started)
+        {
+            incomplete.push_back(entry.second);
+        }
+
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            throw JournalError(std::string{"error "} + strerror(errno) + " opening journal " + path);
+        }
+        inFlight = incomplete.size();
+
+        DEBUG("[Journal::open] ", path, " existed: ", existed, " dirty: ", dirty, " clean shutdown: ", cleanShutdown,
+              " incomplete: ", incomplete.size());
+        return existed && !dirty;
+    }
+
+    unsigned long long Journal::begin(Operation operation, const std::string &id, const std::string &version)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto sequence = ++lastSequence;
+        std::ostringstream record;
+        record << BEGIN_RECORD << ' ' << sequence << ' '
+               << (operation == Operation::UNINSTALL ? UNINSTALL_OPERATION : INSTALL_OPERATION) << ' '
+               << id << ' ' << version << '\n';
+        append(record.str());
+        ++inFlight;
+        return sequence;
+    }
+
+    void Journal::commit(unsigned long long sequence)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (inFlight > 0)
+        {
+            --inFlight;
+        }
+        if (inFlight == 0)
+        {
+            // nothing in flight, the whole journal is obsolete
+            truncate();
+            return;
+        }
+        append(std::string{COMMIT_RECORD} + ' ' + std::to_string(sequence) + '\n');
+    }
+
+    void Journal::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight = 0;
+        dirty = false;
+        truncate();
+    }
+
+    void Journal::markDirty()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dirty = true;
+        append(std::string{DIRTY_RECORD} + '\n');
+    }
+
+    void Journal::markCleanShutdown()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (inFlight == 0)
+        {
+            append(std::string{SHUTDOWN_RECORD} + '\n');
+        }
+    }
+
+    void Journal::append(const std::string &record)
+    {
+        if (fd < 0)
+        {
+            throw JournalError("journal " + path + " is not open");
+        }
+        if (write(fd, record.c_str(), record.size()) != static_cast<ssize_t>(record.size()) || fdatasync(fd) != 0)
+        {
+            throw JournalError(std::string{"error "} + strerror(errno) + " writing journal " + path);
+        }
+    }
+
+    void Journal::truncate()
+    {
+        if (fd >= 0 && (ftruncate(fd, 0) != 0 || fdatasync(fd) != 0))
+        {
+            throw JournalError(std::string{"error "} + strerror(errno) + " truncating journal " + path);
+        }
+        if (dirty)
+        {
+            // an install committing during the deferred maintenance must not make the journal trusted
+            append(std::string{DIRTY_RECORD} + '\n');
+        }
+    }
+
+} // namespace packagemanager
@@ -0,0 +1,127 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LockRegistry.h"
+
+#include <functional>
+
+namespace packagemanager
+{
+
+    std::size_t AppKeyHash::operator()(const AppKey &key) const
+    {
+        std::size_t seed = std::hash<std::string>{}(key.id);
+        seed ^= std::hash<std::string>{}(key.version) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+
+    unsigned int LockRegistry::lock(const std::string &id, const std::string &version, BlockReason *blockedBy)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &entry = entries[AppKey{id, version}];
+        if (blockedBy)
+        {
+            *blockedBy = entry.blockedBy;
+        }
+        return entry.blockedBy != BlockReason::NONE ? 0 : ++entry.count;
+    }
+
+    bool LockRegistry::unlock(const std::string &id, const std::string &version, unsigned int &remaining)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining = 0;
+        auto it = entries.find(AppKey{id, version});
+        if (it == entries.end() || it->second.count == 0)
+        {
+            return false;
+        }
+
+        remaining = --it->second.count;
+        if (remaining == 0 && !it->second.uninstallPending && it->second.blockedBy == BlockReason::NONE)
+        {
+            entries.erase(it);
+        }
+        return true;
+    }
+
+    bool LockRegistry::isLocked(const std::string &id, const std::string &version) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(AppKey{id, version});
+        return it != entries.end() && it->second.count > 0;
+    }
+
+    bool LockRegistry::deferUninstallOrBlock(const std::string &id, const std::string &version, const DeferredUninstall &uninstall)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &entry = entries[AppKey{id, version}];
+        if (entry.count == 0)
+        {
+            entry.blockedBy = BlockReason::UNINSTALL;
+            return false;
+        }
+
+        entry.uninstallPending = true;
+        entry.uninstall = uninstall;
+        return true;
+    }
+
+    bool LockRegistry::takeDeferredUninstall(const std::string &id, const std::string &version, DeferredUninstall &uninstall)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(AppKey{id, version});
+        if (it == entries.end() || it->second.count > 0 || !it->second.uninstallPending)
+        {
+            return false;
+        }
+
+        uninstall = it->second.uninstall;
+        it->second.uninstallPending = false;
+        it->second.blockedBy = BlockReason::UNINSTALL;
+        return true;
+    }
+
+    bool LockRegistry::blockIfUnlocked(const std::string &id, const std::string &version, BlockReason reason)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &entry = entries[AppKey{id, version}];
+        if (entry.count > 0)
+        {
+            return false;
+        }
+        entry.blockedBy = reason;
+        return true;
+    }
+
+    void LockRegistry::unblock(const std::string &id, const std::string &version)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(AppKey{id, version});
+        if (it == entries.end())
+        {
+            return;
+        }
+        it->second.blockedBy = BlockReason::NONE;
+        if (it->second.count == 0 && !it->second.uninstallPending)
+        {
+            entries.erase(it);
+        }
+    }
+
+} // namespace packagemanager
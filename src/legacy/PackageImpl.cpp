@@ -37,6 +37,12 @@ namespace packagemanager
         return false;
     }
 
+    // "frequent" or "rare", decides which app volume is tried first
+    UsageHint parseUsageHint(const std::string &usageHint)
+    {
+        return usageHint == "frequent" ? UsageHint::FREQUENT : usageHint == "rare" ? UsageHint::RARE : UsageHint::DEFAULT;
+    }
+
     Result PackageImpl::Initialize(const std::string &configString, ConfigMetadataArray &appMetaMap)
     {
 
@@ -47,25 +53,21 @@ namespace packagemanager
             ERROR("Failed to configure executor, Status : ", result);
             return FAILED;
         }
-        std::vector<DataStorage::AppDetails> appsDetailsList;
-        const std::string type = "";
-        const std::string id = "";
-        const std::string version = "";
-        const std::string appName = "";
-        const std::string category = "";
-
-        result = executor.GetAppDetailsList(type, id, version, appName, category, appsDetailsList);
+        // paths of all apps come with the list, no catalog query per app
+        std::vector<Executor::InstalledAppPaths> installedApps;
+        result = executor.GetInstalledApps(installedApps);
         if (result != RETURN_SUCCESS)
         {
             ERROR("Failed to retrieve app details list, Status : ", result);
             return FAILED;
         }
-        INFO("[PackageImpl::Initialize] Retrieved ", appsDetailsList.size(), " apps.");
-        for (auto details : appsDetailsList)
+        INFO("[PackageImpl::Initialize] Retrieved ", installedApps.size(), " apps.");
+        for (const auto &app : installedApps)
         {
+            const auto &details = app.details;
             ConfigMetaData configMetaData;
 
-            if (populateConfigValues(details.id, details.version, configMetaData))
+            if (populateConfigValues(app.appPath, app.annotationsPath, configMetaData, details.id))
             {
                 ConfigMetadataKey app = {details.id, details.version};
                 appMetaMap[app] = configMetaData;
@@ -81,15 +83,22 @@ namespace packagemanager
 
     Result PackageImpl::Install(const std::string &packageId, const std::string &version, const NameValues &additionalMetadata, const std::string &fileLocator, ConfigMetaData &configMetadata)
     {
-        std::string type, category, appName;
+        std::string type, category, appName, usageHint, verify, priority;
         // Extract additional metadata
         getKeyValue(additionalMetadata, "type", type);
         getKeyValue(additionalMetadata, "category", category);
         getKeyValue(additionalMetadata, "appName", appName);
+        getKeyValue(additionalMetadata, "usageHint", usageHint);
+        // "content" re-hashes an identical version that is already installed instead of trusting the catalog
+        getKeyValue(additionalMetadata, "verify", verify);
+        // "foreground" for installs the user waits for, they skip the background priority profile
+        getKeyValue(additionalMetadata, "priority", priority);
 
-        INFO("PackageImpl Install, Status : type ", type, " category ", category, " appName ", appName);
+        INFO("PackageImpl Install, Status : type ", type, " category ", category, " appName ", appName, " usageHint ", usageHint);
 
-        uint32_t result = executor.Install(type, packageId, version, fileLocator, appName, category);
+        auto check = verify == "content" ? ReinstallCheck::CONTENT : ReinstallCheck::CATALOG;
+        auto jobPriority = priority == "foreground" ? JobPriority::FOREGROUND : JobPriority::BACKGROUND;
+        uint32_t result = executor.Install(type, packageId, version, fileLocator, appName, category, parseUsageHint(usageHint), check, jobPriority);
         // The executor will handle the installation process, so we return SUCCESS here
         return result == RETURN_SUCCESS ? SUCCESS : FAILED;
     }
@@ -97,15 +106,26 @@ namespace packagemanager
     Result PackageImpl::Lock(const std::string &packageId, const std::string &version, std::string &unpackedPath, ConfigMetaData &appConfig, NameValues &additionalLocks)
     {
         INFO("PackageImpl Lock, packageId: ", packageId, " version: ", version);
-        if (populateConfigValues(packageId, version, appConfig))
+        if (executor.Lock(packageId, version) == RETURN_SUCCESS)
         {
-            unpackedPath = appConfig.appPath;
-            return SUCCESS;
+            if (populateConfigValues(packageId, version, appConfig))
+            {
+                unpackedPath = appConfig.appPath;
+                return SUCCESS;
+            }
+            executor.Unlock(packageId, version);
         }
         ERROR("Failed to lock packageId: ", packageId, " version: ", version);
         return FAILED;
     }
 
+    Result PackageImpl::Unlock(const std::string &packageId, const std::string &version)
+    {
+        INFO("PackageImpl Unlock, packageId: ", packageId, " version: ", version);
+        uint32_t result = executor.Unlock(packageId, version);
+        return result == RETURN_SUCCESS ? SUCCESS : FAILED;
+    }
+
     Result PackageImpl::Uninstall(const std::string &packageId)
     {
         uint32_t result = RETURN_ERROR;
@@ -142,14 +162,27 @@ namespace packagemanager
         std::string unpackedPath;
         uint32_t result = executor.GetAppInstalledPath(packageId, version, unpackedPath); // Assuming appPath is the unpacked path
 
+        std::string configPath;
         if (result == RETURN_ERROR)
+        {
+            unpackedPath.clear();
+        }
+        else if (executor.GetAppAnnotationsPath(packageId, version, configPath) == RETURN_ERROR)
+        {
+            configPath.clear();
+        }
+        return populateConfigValues(unpackedPath, configPath, configMetadata, packageId);
+    }
+
+    bool PackageImpl::populateConfigValues(const std::string &unpackedPath, const std::string &configPath, ConfigMetaData &configMetadata /* out*/, const std::string &packageId)
+    {
+        if (unpackedPath.empty())
         {
             ERROR("Failed to get installed path for app ", packageId);
             return false;
         }
         configMetadata.appPath = unpackedPath;
-        std::string configPath;
-        if (executor.GetAppConfigPath(unpackedPath, configPath) == RETURN_ERROR)
+        if (configPath.empty())
         {
             ERROR("Failed to find config path for app ", packageId);
             return false;
@@ -201,4 +234,24 @@ namespace packagemanager
         INFO("PackageImpl GetFileMetadata, packageId: ", packageId, " version: ", version, " fileLocator: ", fileLocator);
         return populateConfigValues(packageId, version, configMetadata) ? SUCCESS : FAILED;
     }
+    Result PackageImpl::HibernateIdleApps()
+    {
+        unsigned int hibernated{};
+        uint32_t result = executor.HibernateIdleApps(hibernated);
+        INFO("PackageImpl HibernateIdleApps, hibernated: ", hibernated);
+        return result == RETURN_SUCCESS ? SUCCESS : FAILED;
+    }
+
+    Result PackageImpl::GetEvictionPlan(unsigned long long requiredBytes, const std::string &usageHint, NameValues &versions)
+    {
+        std::vector<DataStorage::EvictionCandidate> plan;
+        uint32_t result = executor.GetEvictionPlan(requiredBytes, parseUsageHint(usageHint), plan);
+        versions.clear();
+        for (const auto &candidate : plan)
+        {
+            versions.emplace_back(candidate.id, candidate.version);
+        }
+        return result == RETURN_SUCCESS ? SUCCESS : FAILED;
+    }
+
 }
\ No newline at end of file
@@ -19,6 +19,7 @@
 
 #include "Debug.h"
 #include "SqlDataStorage.h"
+#include "CatalogQueries.h"
 
 #include <fstream>
 #include <string.h>
@@ -53,9 +54,72 @@ namespace packagemanager
             std::time_t todayTime = std::chrono::system_clock::to_time_t(now);
             return std::ctime(&todayTime);
         }
+
+        // points into the row, valid until the statement is stepped or reset
+        DataStorage::TextView ColumnText(sqlite3_stmt *stmt, int column)
+        {
+            auto text = reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+            return DataStorage::TextView{text ? text : "", static_cast<std::size_t>(sqlite3_column_bytes(stmt, column))};
+        }
+
+        // A savepoint on the writer connection, the outermost one is the transaction
+        class SqlTransaction : public DataStorage::Transaction
+        {
+        public:
+            explicit SqlTransaction(ConnectionPool::Lease &&writer) : writer(std::move(writer))
+            {
+                Execute("SAVEPOINT unit_of_work;");
+            }
+
+            ~SqlTransaction() override
+            {
+                if (!committed && sqlite3_exec(writer, "ROLLBACK TO unit_of_work; RELEASE unit_of_work;", nullptr, nullptr, nullptr) != SQLITE_OK)
+                {
+                    ERROR("[SqlTransaction] rollback failed: ", sqlite3_errmsg(writer));
+                }
+            }
+
+            void commit() override
+            {
+                Execute("RELEASE unit_of_work;");
+                committed = true;
+            }
+
+        private:
+            void Execute(const std::string &command)
+            {
+                char *rawErrorMsg{};
+                int rc = sqlite3_exec(writer, command.c_str(), nullptr, nullptr, &rawErrorMsg);
+                SqlUniqueString errorMsg{rawErrorMsg};
+                if (rc != SQLITE_OK)
+                {
+                    throw SqlDataStorageError(std::string{"error "} + (errorMsg ? errorMsg.get() : sqlite3_errmsg(writer)) + " while executing " + command);
+                }
+            }
+
+            ConnectionPool::Lease writer;
+            bool committed{false};
+        };
     } // namespace anonymous
 
-    sqlite3 *SqlDataStorage::sqlite = nullptr;
+    namespace CatalogQueries
+    {
+        const FilteredQuery<2> APP_DATA{"SELECT idx FROM apps", {"type", "app_id"}};
+        const FilteredQuery<2> DATA_PATHS{"SELECT data_path FROM apps", {"type", "app_id"}};
+
+        const FilteredQuery<3> APPS_PATHS{"SELECT IA.app_path FROM installed_apps IA INNER JOIN apps A ON A.idx = IA.app_idx",
+                                          {"A.type", "A.app_id", "IA.version"}};
+        const FilteredQuery<3> APPS_LOCATIONS{"SELECT IA.volume, IA.app_path, IA.hibernated FROM installed_apps IA INNER JOIN apps A ON A.idx = IA.app_idx",
+                                              {"A.type", "A.app_id", "IA.version"}};
+
+        const FilteredQuery<5> APP_DETAILS{"SELECT A.type, A.app_id, IA.version, IA.name, IA.category, IA.url, IA.volume, IA.app_path, IA.hibernated "
+                                           "FROM installed_apps IA INNER JOIN apps A ON A.idx = IA.app_idx",
+                                           {"A.type", "A.app_id", "IA.version", "IA.name", "IA.category"}};
+        // version, name and category filters drop the apps without an installed version, as before
+        const FilteredQuery<5> APP_DETAILS_OUTER_JOIN{"SELECT A.type, A.app_id, IA.version, IA.name, IA.category, IA.url, IA.volume, IA.app_path, IA.hibernated "
+                                                      "FROM apps A LEFT OUTER JOIN installed_apps IA ON IA.app_idx = A.idx",
+                                                      {"A.type", "A.app_id", "IA.version", "IA.name", "IA.category"}};
+    } // namespace CatalogQueries
 
     SqlDataStorage::~SqlDataStorage()
     {
@@ -64,16 +128,44 @@ namespace packagemanager
 
     void SqlDataStorage::Terminate()
     {
-        if (sqlite)
+        connections.close();
+    }
+
+    void SqlDataStorage::Initialize(IntegrityCheck check)
+    {
+        InitDB(check);
+    }
+
+    std::unique_ptr<DataStorage::Transaction> SqlDataStorage::BeginTransaction()
+    {
+        return std::unique_ptr<Transaction>{new SqlTransaction{connections.writer()}};
+    }
+
+    bool SqlDataStorage::CheckIntegrity()
+    {
+        DEBUG("[SqlDataStorage::CheckIntegrity] ", db_path);
+        sqlite3 *connection{};
+        if (sqlite3_open_v2(db_path.c_str(), &connection, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
         {
-            sqlite3_close(sqlite);
+            ERROR("[SqlDataStorage::CheckIntegrity] Unable to open ", db_path, ": ", sqlite3_errmsg(connection));
+            sqlite3_close(connection);
+            return false;
         }
-        sqlite = nullptr;
+
+        bool integrityCheckFailed{true};
+        char *rawErrorMsg{};
+        int rc = sqlite3_exec(connection, "PRAGMA integrity_check;", [](void *integrityCheckFailed, int, char **resp, char **) -> int
+                              {
+                *static_cast<bool*>(integrityCheckFailed) = strcmp(resp[0], "ok");
+                return 0; }, &integrityCheckFailed, &rawErrorMsg);
+        SqlUniqueString errorMsg{rawErrorMsg};
+        sqlite3_close(connection);
+        return rc == SQLITE_OK && !integrityCheckFailed;
     }
 
-    void SqlDataStorage::Initialize()
+    bool SqlDataStorage::WasCreated() const
     {
-        InitDB();
+        return created;
     }
 
     void SqlDataStorage::AddInstalledApp(const std::string &type,
@@ -83,10 +175,12 @@ namespace packagemanager
                                          const std::string &appName,
                                          const std::string &category,
                                          const std::string &appPath,
-                                         const std::string &appStoragePath)
+                                         const std::string &appStoragePath,
+                                         const std::string &volume)
     {
         auto timeCreated = timeNow();
 
+        auto transaction = BeginTransaction();
         int appIdx;
         try
         {
@@ -97,7 +191,8 @@ namespace packagemanager
             InsertIntoApps(type, id, appStoragePath, timeCreated);
             appIdx = GetAppIdx(type, id);
         }
-        InsertIntoInstalledApps(appIdx, version, appName, category, url, appPath, timeCreated);
+        InsertIntoInstalledApps(appIdx, version, appName, category, url, appPath, volume, timeCreated);
+        transaction->commit();
     }
 
     bool SqlDataStorage::IsAppInstalled(const std::string &type,
@@ -105,15 +200,14 @@ namespace packagemanager
                                         const std::string &version)
     {
         DEBUG("[SqlDataStorage::IsAppInstalled] ");
-        std::string query = "SELECT idx FROM installed_apps WHERE app_idx IN (SELECT idx FROM apps WHERE (?1 IS NULL OR type = ?1) AND app_id = ?2 AND version = ?3);";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "SELECT idx FROM installed_apps WHERE app_idx IN (SELECT idx FROM apps WHERE (?1 IS NULL OR type = ?1) AND app_id = ?2 AND version = ?3);";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.empty() ? nullptr : id.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, version.empty() ? nullptr : version.c_str(), -1, SQLITE_TRANSIENT);
         int rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
         if (rc == SQLITE_ROW)
         {
             return true;
@@ -124,24 +218,23 @@ namespace packagemanager
         }
         else
         {
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
     }
 
     DataStorage::AppDetails SqlDataStorage::GetAppDetails(const std::string &packageId)
     {
-        std::string query = "SELECT type, app_id, version, name, category, url FROM installed_apps "
-                            "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
-                            "WHERE app_id = ?1";
+        static const std::string query = "SELECT type, app_id, version, name, category, url FROM installed_apps "
+                                         "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
+                                         "WHERE app_id = ?1";
 
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, packageId.c_str(), -1, SQLITE_TRANSIENT);
         if (sqlite3_step(stmt) != SQLITE_ROW)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
         DataStorage::AppDetails appDetails{
             reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), // type
@@ -152,7 +245,6 @@ namespace packagemanager
             reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5))  // url
         };
 
-        sqlite3_finalize(stmt);
         return appDetails;
     }
 
@@ -160,33 +252,29 @@ namespace packagemanager
     {
 
         std::string type{};
-        std::string query = "SELECT type FROM apps WHERE app_id ==  $1;";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "SELECT type FROM apps WHERE app_id ==  $1;";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
         if (sqlite3_step(stmt) != SQLITE_ROW)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
         auto col1 = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
         type = (col1 ? col1 : "");
-        sqlite3_finalize(stmt);
         return type;
     }
 
     bool SqlDataStorage::IsAppData(const std::string &type,
                                    const std::string &id)
     {
-        std::string query = "SELECT idx FROM apps WHERE (?1 IS NULL OR type = ?1) AND (?2 IS NULL OR app_id = ?2)";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
-
-        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, id.empty() ? nullptr : id.c_str(), -1, SQLITE_TRANSIENT);
+        const auto &query = CatalogQueries::APP_DATA;
+        const FilteredQuery<2>::Values values{&type, &id};
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query.sql(values)};
+        query.bind(stmt, values);
         int rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
         if (rc == SQLITE_ROW)
         {
             return true;
@@ -197,7 +285,7 @@ namespace packagemanager
         }
         else
         {
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
     }
 
@@ -205,8 +293,11 @@ namespace packagemanager
                                             const std::string &id,
                                             const std::string &version)
     {
+        auto transaction = BeginTransaction();
         ClearMetadata(type, id, version, "");
+        DeleteFromAppFiles(type, id, version);
         DeleteFromInstalledApps(type, id, version);
+        transaction->commit();
     }
 
     void SqlDataStorage::RemoveAppData(const std::string &type,
@@ -221,14 +312,14 @@ namespace packagemanager
                                      const std::string &key,
                                      const std::string &value)
     {
-        std::string query = "INSERT OR REPLACE INTO metadata(app_idx, meta_key, meta_value) "
-                            "VALUES("
-                            "(SELECT installed_apps.idx FROM installed_apps INNER JOIN apps ON apps.idx = installed_apps.app_idx WHERE type = ?1 AND app_id = ?2 AND version = ?3),"
-                            "?4,"
-                            "?5);";
+        static const std::string query = "INSERT OR REPLACE INTO metadata(app_idx, meta_key, meta_value) "
+                                         "VALUES("
+                                         "(SELECT installed_apps.idx FROM installed_apps INNER JOIN apps ON apps.idx = installed_apps.app_idx WHERE type = ?1 AND app_id = ?2 AND version = ?3),"
+                                         "?4,"
+                                         "?5);";
 
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
@@ -236,7 +327,19 @@ namespace packagemanager
         sqlite3_bind_text(stmt, 4, key.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 5, value.c_str(), -1, SQLITE_TRANSIENT);
         ExecuteSqlStep(stmt);
-        sqlite3_finalize(stmt);
+    }
+
+    void SqlDataStorage::SetMetadata(const std::string &type,
+                                     const std::string &id,
+                                     const std::string &version,
+                                     const MetadataValues &values)
+    {
+        auto transaction = BeginTransaction();
+        for (const auto &value : values)
+        {
+            SetMetadata(type, id, version, value.first, value.second);
+        }
+        transaction->commit();
     }
 
     // key can be empty to clear all metadata of an app
@@ -245,36 +348,34 @@ namespace packagemanager
                                        const std::string &version,
                                        const std::string &key)
     {
-        std::string query = "DELETE FROM metadata "
-                            "WHERE metadata.idx IN ("
-                            "SELECT metadata.idx FROM metadata "
-                            "INNER JOIN installed_apps ON installed_apps.idx = metadata.app_idx "
-                            "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
-                            "WHERE type = ?1 AND app_id = ?2 AND version = ?3 AND (?4 IS NULL OR meta_key = ?4));";
+        static const std::string query = "DELETE FROM metadata "
+                                         "WHERE metadata.idx IN ("
+                                         "SELECT metadata.idx FROM metadata "
+                                         "INNER JOIN installed_apps ON installed_apps.idx = metadata.app_idx "
+                                         "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
+                                         "WHERE type = ?1 AND app_id = ?2 AND version = ?3 AND (?4 IS NULL OR meta_key = ?4));";
 
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, version.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, key.empty() ? nullptr : key.c_str(), -1, SQLITE_TRANSIENT);
         ExecuteSqlStep(stmt);
-        sqlite3_finalize(stmt);
     }
 
     DataStorage::AppMetadata SqlDataStorage::GetMetadata(const std::string &type,
                                                          const std::string &id,
                                                          const std::string &version)
     {
-
-        sqlite3_stmt *stmt;
-        std::string appDetailsQuery =
+        static const std::string appDetailsQuery =
             "SELECT type, app_id, version, name, category, url FROM installed_apps "
             "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
             "WHERE type = ?1 AND app_id = ?2 AND version = ?3";
 
-        sqlite3_prepare_v2(sqlite, appDetailsQuery.c_str(), appDetailsQuery.length(), &stmt, nullptr);
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), appDetailsQuery};
 
         sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
@@ -282,66 +383,320 @@ namespace packagemanager
 
         if (sqlite3_step(stmt) != SQLITE_ROW)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
         DataStorage::AppDetails appDetails{
             reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)),
             reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)),
             reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5))};
 
-        sqlite3_finalize(stmt);
+        static const std::string metadataQuery = "SELECT meta_key, meta_value FROM metadata "
+                                                 "INNER JOIN installed_apps ON installed_apps.idx = metadata.app_idx "
+                                                 "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
+                                                 "WHERE type = ?1 AND app_id = ?2 AND version = ?3";
+
+        StatementCache::Statement metadataStmt{connection.statements(), metadataQuery};
+        sqlite3_bind_text(metadataStmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(metadataStmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(metadataStmt, 3, version.c_str(), -1, SQLITE_TRANSIENT);
+
+        std::vector<std::pair<std::string, std::string> > metadata;
+        int rc{};
+        while ((rc = sqlite3_step(metadataStmt)) == SQLITE_ROW)
+        {
+            std::pair<std::string, std::string> keyValue{
+                reinterpret_cast<const char *>(sqlite3_column_text(metadataStmt, 0)),
+                reinterpret_cast<const char *>(sqlite3_column_text(metadataStmt, 1))};
+            metadata.push_back(keyValue);
+        }
+        if (rc != SQLITE_DONE)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
 
-        std::string metadataQuery = "SELECT meta_key, meta_value FROM metadata "
-                                    "INNER JOIN installed_apps ON installed_apps.idx = metadata.app_idx "
-                                    "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
-                                    "WHERE type = ?1 AND app_id = ?2 AND version = ?3";
 
-        sqlite3_prepare_v2(sqlite, metadataQuery.c_str(), metadataQuery.length(), &stmt, nullptr);
+        return AppMetadata{appDetails, metadata};
+    }
 
-        sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
+    void SqlDataStorage::SetAppUsage(const std::string &type,
+                                     const std::string &id,
+                                     const std::string &version,
+                                     const std::vector<Filesystem::FileUsage> &manifest)
+    {
+        // one transaction for the whole manifest, apps can easily have thousands of files
+        auto transaction = BeginTransaction();
+        auto connection = connections.writer();
+        auto installedAppIdx = GetInstalledAppIdx(type, id, version);
+        DeleteFromAppFiles(type, id, version);
+
+        static const std::string query = "INSERT INTO app_files VALUES(NULL, $1, $2, $3, $4);";
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        AppUsage usage{};
+        for (const auto &file : manifest)
+        {
+            sqlite3_bind_int(stmt, 1, installedAppIdx);
+            sqlite3_bind_text(stmt, 2, file.path.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(file.size));
+            sqlite3_bind_int64(stmt, 4, static_cast<sqlite3_int64>(file.blocks));
+            ExecuteSqlStep(stmt);
+            sqlite3_reset(stmt);
+            usage.bytes += file.size;
+            usage.blocks += file.blocks;
+        }
+
+        static const std::string sizeQuery = "UPDATE installed_apps SET size_bytes = $1, size_blocks = $2 WHERE idx = $3;";
+        StatementCache::Statement sizeStmt{connection.statements(), sizeQuery};
+        sqlite3_bind_int64(sizeStmt, 1, static_cast<sqlite3_int64>(usage.bytes));
+        sqlite3_bind_int64(sizeStmt, 2, static_cast<sqlite3_int64>(usage.blocks));
+        sqlite3_bind_int(sizeStmt, 3, installedAppIdx);
+        ExecuteSqlStep(sizeStmt);
+
+        transaction->commit();
+    }
+
+    bool SqlDataStorage::GetAppUsage(const std::string &type,
+                                     const std::string &id,
+                                     const std::string &version,
+                                     AppUsage &usage)
+    {
+        static const std::string query = "SELECT size_bytes, size_blocks FROM installed_apps "
+                                         "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
+                                         "WHERE (?1 IS NULL OR type = ?1) AND app_id = ?2 AND version = ?3";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, version.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_ROW)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
 
-        std::vector<std::pair<std::string, std::string> > metadata;
+        // apps installed before usage accounting existed have no size recorded yet
+        bool recorded = sqlite3_column_type(stmt, 0) != SQLITE_NULL;
+        if (recorded)
+        {
+            usage.bytes = static_cast<unsigned long long>(sqlite3_column_int64(stmt, 0));
+            usage.blocks = static_cast<unsigned long long>(sqlite3_column_int64(stmt, 1));
+        }
+        return recorded;
+    }
+
+    DataStorage::AppUsage SqlDataStorage::GetTotalUsage()
+    {
+        static const std::string query = "SELECT IFNULL(SUM(size_bytes), 0), IFNULL(SUM(size_blocks), 0) FROM installed_apps;";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+        auto usage = GetUsageSum(stmt);
+        return usage;
+    }
+
+    DataStorage::AppUsage SqlDataStorage::GetVolumeUsage(const std::string &volume)
+    {
+        static const std::string query = "SELECT IFNULL(SUM(size_bytes), 0), IFNULL(SUM(size_blocks), 0) FROM installed_apps WHERE volume = ?1;";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+        sqlite3_bind_text(stmt, 1, volume.c_str(), -1, SQLITE_TRANSIENT);
+        auto usage = GetUsageSum(stmt);
+        return usage;
+    }
+
+    void SqlDataStorage::SetLastLocked(const std::string &id,
+                                       const std::string &version,
+                                       long long timestamp)
+    {
+        static const std::string query = "UPDATE installed_apps SET last_locked = ?3 "
+                                         "WHERE version = ?2 AND app_idx IN (SELECT idx FROM apps WHERE app_id = ?1);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 3, timestamp);
+        ExecuteSqlStep(stmt);
+    }
+
+    std::vector<DataStorage::EvictionCandidate> SqlDataStorage::GetEvictionCandidates(const std::string &volume)
+    {
+        // installed_apps.idx grows with every install, a higher idx of the same app is a newer install
+        static const std::string query = "SELECT apps.type, apps.app_id, ia.version, ia.size_bytes, ia.size_blocks, IFNULL(ia.last_locked, 0), "
+                                         "EXISTS (SELECT 1 FROM installed_apps newer WHERE newer.app_idx = ia.app_idx AND newer.idx > ia.idx) "
+                                         "FROM installed_apps ia INNER JOIN apps ON apps.idx = ia.app_idx "
+                                         "WHERE ia.volume = ?1 AND ia.hibernated = 0 "
+                                         "ORDER BY IFNULL(ia.last_locked, 0), ia.idx;";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+        sqlite3_bind_text(stmt, 1, volume.c_str(), -1, SQLITE_TRANSIENT);
+
+        std::vector<EvictionCandidate> candidates;
         int rc{};
         while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
         {
-            std::pair<std::string, std::string> keyValue{
-                reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)),
-                reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1))};
-            metadata.push_back(keyValue);
+            EvictionCandidate candidate{};
+            candidate.type = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            candidate.id = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            candidate.version = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+            candidate.usageRecorded = sqlite3_column_type(stmt, 3) != SQLITE_NULL;
+            candidate.usage.bytes = static_cast<unsigned long long>(sqlite3_column_int64(stmt, 3));
+            candidate.usage.blocks = static_cast<unsigned long long>(sqlite3_column_int64(stmt, 4));
+            candidate.lastLocked = sqlite3_column_int64(stmt, 5);
+            candidate.superseded = sqlite3_column_int(stmt, 6) != 0;
+            candidates.push_back(candidate);
         }
         if (rc != SQLITE_DONE)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
+        return candidates;
+    }
 
-        sqlite3_finalize(stmt);
+    void SqlDataStorage::SetHibernated(const std::string &id,
+                                       const std::string &version,
+                                       bool hibernated)
+    {
+        static const std::string query = "UPDATE installed_apps SET hibernated = ?3 "
+                                         "WHERE version = ?2 AND app_idx IN (SELECT idx FROM apps WHERE app_id = ?1);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
-        return AppMetadata{appDetails, metadata};
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 3, hibernated ? 1 : 0);
+        ExecuteSqlStep(stmt);
+        connection.invalidate();
+    }
+
+    void SqlDataStorage::SetRehydrationTime(const std::string &id,
+                                            const std::string &version,
+                                            long long milliseconds)
+    {
+        static const std::string query = "UPDATE installed_apps SET rehydration_ms = ?3 "
+                                         "WHERE version = ?2 AND app_idx IN (SELECT idx FROM apps WHERE app_id = ?1);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 3, milliseconds);
+        ExecuteSqlStep(stmt);
+    }
+
+    void SqlDataStorage::SetArchiveDigest(const std::string &id,
+                                          const std::string &version,
+                                          const std::string &digest)
+    {
+        static const std::string query = "UPDATE installed_apps SET archive_digest = ?3 "
+                                         "WHERE version = ?2 AND app_idx IN (SELECT idx FROM apps WHERE app_id = ?1);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, digest.c_str(), -1, SQLITE_TRANSIENT);
+        ExecuteSqlStep(stmt);
+    }
+
+    std::string SqlDataStorage::GetArchiveDigest(const std::string &id,
+                                                 const std::string &version)
+    {
+        static const std::string query = "SELECT archive_digest FROM installed_apps "
+                                         "WHERE version = ?2 AND app_idx IN (SELECT idx FROM apps WHERE app_id = ?1);";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
+
+        std::string digest;
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+        {
+            digest = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+        }
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        return digest;
     }
 
-    void SqlDataStorage::InitDB()
+    std::vector<DataStorage::HibernationCandidate> SqlDataStorage::GetHibernationCandidates(long long lockedBefore)
+    {
+        static const std::string query = "SELECT apps.type, apps.app_id, ia.version, IFNULL(ia.last_locked, 0), IFNULL(ia.rehydration_ms, -1) "
+                                         "FROM installed_apps ia INNER JOIN apps ON apps.idx = ia.app_idx "
+                                         "WHERE ia.hibernated = 0 AND IFNULL(ia.last_locked, 0) <= ?1 "
+                                         "ORDER BY IFNULL(ia.last_locked, 0), ia.idx;";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+        sqlite3_bind_int64(stmt, 1, lockedBefore);
+
+        std::vector<HibernationCandidate> candidates;
+        int rc{};
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            HibernationCandidate candidate{};
+            candidate.type = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            candidate.id = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            candidate.version = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+            candidate.lastLocked = sqlite3_column_int64(stmt, 3);
+            candidate.rehydrationTime = sqlite3_column_int64(stmt, 4);
+            candidates.push_back(candidate);
+        }
+        if (rc != SQLITE_DONE)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        return candidates;
+    }
+
+    DataStorage::AppUsage SqlDataStorage::GetUsageSum(sqlite3_stmt *stmt) const
+    {
+        if (sqlite3_step(stmt) != SQLITE_ROW)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        }
+        return AppUsage{static_cast<unsigned long long>(sqlite3_column_int64(stmt, 0)),
+                        static_cast<unsigned long long>(sqlite3_column_int64(stmt, 1))};
+    }
+
+    void SqlDataStorage::InitDB(IntegrityCheck check)
     {
         DEBUG("Initializing database");
         Terminate();
         OpenConnection();
-        Validate();
+        Validate(check);
+        created = !TableExists("apps");
         CreateTables();
+        MigrateTables();
         EnableForeignKeys();
     }
 
     void SqlDataStorage::OpenConnection()
     {
         DEBUG("Opening database connection: ", db_path);
-        bool rc = sqlite3_open(db_path.c_str(), &sqlite);
-        if (rc)
-        {
-            auto msg = std::string{"Error opening connection: "} + std::to_string(rc) + " - " + sqlite3_errmsg(sqlite);
-            throw SqlDataStorageError(msg);
-        }
+        // readers only run concurrently with the writer in WAL mode
+        const unsigned int maxReaders = profile.journalMode == JournalMode::WAL ? profile.readConnections : 0;
+        connections.open(db_path, maxReaders, ConnectionPragmas());
+        ApplyProfile();
+    }
+
+    std::string SqlDataStorage::ConnectionPragmas() const
+    {
+        const char *tempStore = profile.tempStore == TempStore::FILE ? "FILE" : profile.tempStore == TempStore::MEMORY ? "MEMORY" : "DEFAULT";
+        return "PRAGMA mmap_size = " + std::to_string(profile.mmapSize) + ";"
+               "PRAGMA cache_size = " + std::to_string(profile.cacheSize) + ";"
+               "PRAGMA temp_store = " + tempStore + ";";
+    }
+
+    void SqlDataStorage::ApplyProfile() const
+    {
+        // journal_mode is stored in the database file, it is set either way to switch back from WAL
+        ExecuteCommand(profile.journalMode == JournalMode::WAL ? "PRAGMA journal_mode = WAL;" : "PRAGMA journal_mode = DELETE;");
+        const char *synchronous = profile.synchronous == SyncLevel::OFF ? "OFF" : profile.synchronous == SyncLevel::NORMAL ? "NORMAL" : "FULL";
+        ExecuteCommand(std::string{"PRAGMA synchronous = "} + synchronous + ";");
+        ExecuteCommand(ConnectionPragmas());
     }
 
     void SqlDataStorage::CreateTables() const
@@ -380,6 +735,60 @@ namespace packagemanager
                        ");");
     }
 
+    // Tables are created with their original layout above, every later change is applied
+    // here so that fresh and existing databases end up with the same schema.
+    void SqlDataStorage::MigrateTables() const
+    {
+        // MIGRATIONS[n] takes the schema from version n to n + 1
+        static const std::vector<std::vector<std::string>> MIGRATIONS{
+            {"ALTER TABLE installed_apps ADD COLUMN size_bytes INTEGER;",
+             "ALTER TABLE installed_apps ADD COLUMN size_blocks INTEGER;",
+             "CREATE TABLE IF NOT EXISTS app_files("
+             "idx INTEGER PRIMARY KEY,"
+             "installed_app_idx INTEGER NOT NULL,"
+             "path TEXT NOT NULL,"
+             "size INTEGER NOT NULL,"
+             "blocks INTEGER NOT NULL,"
+             "FOREIGN KEY(installed_app_idx) REFERENCES installed_apps(idx),"
+             "UNIQUE(installed_app_idx, path)"
+             ");"},
+            // app volume name, empty for appspath
+            {"ALTER TABLE installed_apps ADD COLUMN volume TEXT NOT NULL DEFAULT '';"},
+            // seconds since epoch of the last Lock, for eviction
+            {"ALTER TABLE installed_apps ADD COLUMN last_locked INTEGER;"},
+            // packed by hibernation, and how long unpacking it again took
+            {"ALTER TABLE installed_apps ADD COLUMN hibernated INTEGER NOT NULL DEFAULT 0;",
+             "ALTER TABLE installed_apps ADD COLUMN rehydration_ms INTEGER;"},
+            // sha256 of the source archive, identical reinstalls are skipped
+            {"ALTER TABLE installed_apps ADD COLUMN archive_digest TEXT;"}};
+        assert(MIGRATIONS.size() == SCHEMA_VERSION);
+
+        auto version = GetSchemaVersion();
+        DEBUG("Database schema version ", version, ", expected ", SCHEMA_VERSION);
+        for (; version < SCHEMA_VERSION; ++version)
+        {
+            // a step and its user_version are committed together, a crash in between
+            // leaves the previous version to be migrated again on the next start
+            SqlTransaction transaction{connections.writer()};
+            for (const auto &command : MIGRATIONS[version])
+            {
+                ExecuteCommand(command);
+            }
+            ExecuteCommand("PRAGMA user_version = " + std::to_string(version + 1) + ";");
+            transaction.commit();
+        }
+    }
+
+    int SqlDataStorage::GetSchemaVersion() const
+    {
+        int version{0};
+        ExecuteCommand("PRAGMA user_version;", [](void *version, int, char **resp, char **) -> int
+                       {
+                *static_cast<int*>(version) = resp[0] ? atoi(resp[0]) : 0;
+                return 0; }, &version);
+        return version;
+    }
+
     void SqlDataStorage::EnableForeignKeys() const
     {
         DEBUG("Enabling foreign keys");
@@ -388,8 +797,9 @@ namespace packagemanager
 
     void SqlDataStorage::ExecuteCommand(const std::string &command, SqlCallback callback, void *val) const
     {
+        auto connection = connections.writer();
         char *rawErrorMsg{};
-        int rc = sqlite3_exec(sqlite, command.c_str(), callback, val, &rawErrorMsg);
+        int rc = sqlite3_exec(connection, command.c_str(), callback, val, &rawErrorMsg);
 
         SqlUniqueString errorMsg{rawErrorMsg};
         if (rc != SQLITE_OK || errorMsg)
@@ -399,12 +809,19 @@ namespace packagemanager
         }
     }
 
-    void SqlDataStorage::Validate() const
+    void SqlDataStorage::Validate(IntegrityCheck check) const
     {
+        if (check == IntegrityCheck::NONE)
+        {
+            DEBUG("Skipping database integrity check");
+            return;
+        }
+
         bool integrityCheckFailed{true};
         try
         {
-            ExecuteCommand("PRAGMA integrity_check;", [](void *integrityCheckFailed, int, char **resp, char **) -> int
+            ExecuteCommand(check == IntegrityCheck::QUICK ? "PRAGMA quick_check;" : "PRAGMA integrity_check;",
+                           [](void *integrityCheckFailed, int, char **resp, char **) -> int
                            {
                 *static_cast<bool*>(integrityCheckFailed) = strcmp(resp[0], "ok");
                 return 0; }, &integrityCheckFailed);
@@ -418,37 +835,100 @@ namespace packagemanager
         if (integrityCheckFailed)
         {
             ERROR("database integrity check failed, dropping tables");
+            auto connection = connections.writer();
+            connection.invalidate();
             ExecuteCommand("DROP TABLE apps;");
             ExecuteCommand("DROP TABLE installed_apps;");
             ExecuteCommand("DROP TABLE metadata;");
+            ExecuteCommand("DROP TABLE IF EXISTS app_files;");
+            ExecuteCommand("PRAGMA user_version = 0;");
         }
     }
 
-    std::vector<std::string> SqlDataStorage::GetAppsPaths(const std::string &type, const std::string &id, const std::string &version)
+    bool SqlDataStorage::TableExists(const std::string &table) const
     {
+        static const std::string query = "SELECT name FROM sqlite_master WHERE type = 'table' AND name = ?1;";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
-        std::string query = "SELECT app_path FROM installed_apps WHERE app_idx IN (SELECT idx FROM apps WHERE (?1 IS NULL OR type = ?1) AND (?2 IS NULL OR app_id = ?2)) AND (?3 IS NULL OR version = ?3)";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+        int rc = sqlite3_step(stmt);
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        return rc == SQLITE_ROW;
+    }
 
-        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, id.empty() ? nullptr : id.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, version.empty() ? nullptr : version.c_str(), -1, SQLITE_TRANSIENT);
+    std::vector<std::string> SqlDataStorage::GetAppsPaths(const std::string &type, const std::string &id, const std::string &version)
+    {
+        const auto &query = CatalogQueries::APPS_PATHS;
+        const FilteredQuery<3>::Values values{&type, &id, &version};
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query.sql(values)};
+        query.bind(stmt, values);
         auto paths = GetPaths(stmt);
-        sqlite3_finalize(stmt);
         return paths;
     }
 
-    std::vector<std::string> SqlDataStorage::GetDataPaths(const std::string &type, const std::string &id)
+    std::vector<DataStorage::AppLocation> SqlDataStorage::GetAppsLocations(const std::string &type, const std::string &id, const std::string &version)
     {
-        std::string query = "SELECT data_path FROM apps WHERE (?1 IS NULL OR type = ?1) AND (?2 IS NULL OR app_id = ?2)";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        const auto &query = CatalogQueries::APPS_LOCATIONS;
+        const FilteredQuery<3>::Values values{&type, &id, &version};
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query.sql(values)};
+        query.bind(stmt, values);
 
-        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, id.empty() ? nullptr : id.c_str(), -1, SQLITE_TRANSIENT);
+        std::vector<AppLocation> locations;
+        int rc{};
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            auto path = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            locations.push_back(AppLocation{reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), path ? path : "",
+                                            sqlite3_column_int(stmt, 2) != 0});
+        }
+        if (rc != SQLITE_DONE)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        return locations;
+    }
+
+    std::vector<DataStorage::InstalledApp> SqlDataStorage::GetInstalledApps()
+    {
+        static const std::string query = "SELECT A.type, A.app_id, IA.version, IA.name, IA.category, IA.url, IA.volume, IA.app_path, IA.hibernated, IA.size_bytes IS NOT NULL "
+                                         "FROM installed_apps IA INNER JOIN apps A ON A.idx = IA.app_idx;";
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        std::vector<InstalledApp> apps;
+        int rc{};
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            auto text = [&stmt](int column)
+            {
+                return reinterpret_cast<const char *>(sqlite3_column_text(stmt, column));
+            };
+            auto path = text(7);
+            apps.push_back(InstalledApp{AppDetails{text(0), text(1), text(2), text(3), text(4), text(5)},
+                                        AppLocation{text(6), path ? path : "", sqlite3_column_int(stmt, 8) != 0},
+                                        sqlite3_column_int(stmt, 9) != 0});
+        }
+        if (rc != SQLITE_DONE)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        return apps;
+    }
+
+    std::vector<std::string> SqlDataStorage::GetDataPaths(const std::string &type, const std::string &id)
+    {
+        const auto &query = CatalogQueries::DATA_PATHS;
+        const FilteredQuery<2>::Values values{&type, &id};
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query.sql(values)};
+        query.bind(stmt, values);
         auto paths = GetPaths(stmt);
-        sqlite3_finalize(stmt);
         return paths;
     }
 
@@ -462,7 +942,7 @@ namespace packagemanager
         }
         if (rc != SQLITE_DONE)
         {
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite3_db_handle(stmt)));
         }
         return paths;
     }
@@ -470,30 +950,12 @@ namespace packagemanager
     std::vector<DataStorage::AppDetails> SqlDataStorage::GetAppDetailsList(const std::string &type, const std::string &id, const std::string &version,
                                                                            const std::string &appName, const std::string &category)
     {
-        std::string query = "SELECT A.type,A.app_id,IA.version,IA.name,IA.category,IA.url FROM installed_apps IA, apps A WHERE (IA.app_idx == A.idx) AND (?1 IS NULL OR A.type = ?1) AND (?2 IS NULL OR app_id = ?2) "
-                            "AND (?3 IS NULL OR version = ?3) AND (?4 IS NULL OR name = ?4) AND (?5 IS NULL OR category = ?5);";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, id.empty() ? nullptr : id.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, version.empty() ? nullptr : version.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 4, appName.empty() ? nullptr : appName.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 5, category.empty() ? nullptr : category.c_str(), -1, SQLITE_TRANSIENT);
-        int rc{};
         std::vector<AppDetails> appsList;
-        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
-        {
-
-            appsList.push_back(AppDetails{reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)),
-                                          reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)),
-                                          reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5))});
-        }
-        if (rc != SQLITE_DONE)
+        VisitAppDetails([&appsList](const AppDetailsView &row)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
-        }
-        sqlite3_finalize(stmt);
+            appsList.push_back(row.str());
+            return true;
+        }, false, type, id, version, appName, category);
         return appsList;
     }
 
@@ -502,47 +964,56 @@ namespace packagemanager
                                                                                     const std::string &appName, const std::string &category)
     {
         DEBUG("[SqlDataStorage::GetAppDetailsListOuterJoin] Enter");
-        std::string query = "SELECT type, app_id, version, name, category, url FROM apps LEFT OUTER JOIN installed_apps ON installed_apps.app_idx = apps.idx WHERE (?1 IS NULL OR type = ?1) AND (?2 IS NULL OR app_id = ?2) "
-                            "AND (?3 IS NULL OR version = ?3) AND (?4 IS NULL OR name = ?4) AND (?5 IS NULL OR category = ?5);";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
-        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, id.empty() ? nullptr : id.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, version.empty() ? nullptr : version.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 4, appName.empty() ? nullptr : appName.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 5, category.empty() ? nullptr : category.c_str(), -1, SQLITE_TRANSIENT);
-        int rc{};
         std::vector<AppDetails> appsList;
-        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        VisitAppDetails([&appsList](const AppDetailsView &row)
         {
+            appsList.push_back(row.str());
+            return true;
+        }, true, type, id, version, appName, category);
+        return appsList;
+    }
 
-            appsList.push_back(AppDetails{reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)),
-                                          reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)),
-                                          reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4)), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5))});
+    void SqlDataStorage::VisitAppDetails(const AppDetailsVisitor &visitor, bool outerJoin, const std::string &type, const std::string &id,
+                                         const std::string &version, const std::string &appName, const std::string &category)
+    {
+        const auto &query = outerJoin ? CatalogQueries::APP_DETAILS_OUTER_JOIN : CatalogQueries::APP_DETAILS;
+        const FilteredQuery<5>::Values values{&type, &id, &version, &appName, &category};
+        auto connection = connections.reader();
+        StatementCache::Statement stmt{connection.statements(), query.sql(values)};
+        query.bind(stmt, values);
+        int rc{};
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        {
+            const AppDetailsView row{ColumnText(stmt, 0), ColumnText(stmt, 1), ColumnText(stmt, 2),
+                                     ColumnText(stmt, 3), ColumnText(stmt, 4), ColumnText(stmt, 5),
+                                     ColumnText(stmt, 6), ColumnText(stmt, 7), sqlite3_column_int(stmt, 8) != 0};
+            if (!visitor(row))
+            {
+                // the rest of the rows are never produced, the statement is reset on release
+                return;
+            }
         }
         if (rc != SQLITE_DONE)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
-        sqlite3_finalize(stmt);
-        return appsList;
     }
+
     void SqlDataStorage::InsertIntoApps(const std::string &type,
                                         const std::string &id,
                                         const std::string &appPath,
                                         const std::string &timeCreated)
     {
-        std::string query = "INSERT INTO apps VALUES(NULL, $1, $2, $3, $4);";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "INSERT INTO apps VALUES(NULL, $1, $2, $3, $4);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 3, appPath.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 4, timeCreated.c_str(), -1, SQLITE_TRANSIENT);
         ExecuteSqlStep(stmt);
-        sqlite3_finalize(stmt);
+        connection.invalidate();
     }
 
     int SqlDataStorage::GetAppIdx(const std::string &type,
@@ -550,19 +1021,17 @@ namespace packagemanager
     {
 
         int appIdx{INVALID_INDEX};
-        std::string query = "SELECT idx FROM apps WHERE type == $1 AND app_id ==  $2;";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "SELECT idx FROM apps WHERE type == $1 AND app_id ==  $2;";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
         if (sqlite3_step(stmt) != SQLITE_ROW)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
         }
         appIdx = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
         return appIdx;
     }
 
@@ -572,13 +1041,15 @@ namespace packagemanager
                                                  const std::string &category,
                                                  const std::string &url,
                                                  const std::string &appPath,
+                                                 const std::string &volume,
                                                  const std::string &timeCreated)
     {
 
         assert(appIdx != INVALID_INDEX);
-        std::string query = "INSERT INTO installed_apps VALUES(NULL, $1, $2, $3, $4, $5, $6, $7, NULL, NULL);";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "INSERT INTO installed_apps(app_idx, version, name, category, url, app_path, created, volume) "
+                                         "VALUES($1, $2, $3, $4, $5, $6, $7, $8);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, std::to_string(appIdx).c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
@@ -587,8 +1058,9 @@ namespace packagemanager
         sqlite3_bind_text(stmt, 5, url.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 6, appPath.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 7, timeCreated.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 8, volume.c_str(), -1, SQLITE_TRANSIENT);
         ExecuteSqlStep(stmt);
-        sqlite3_finalize(stmt);
+        connection.invalidate();
     }
 
     void SqlDataStorage::DeleteFromInstalledApps(const std::string &type,
@@ -598,28 +1070,67 @@ namespace packagemanager
 
         auto appIdx = GetAppIdx(type, id);
 
-        std::string query = "DELETE FROM installed_apps WHERE app_idx == $1 AND version == $2;";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "DELETE FROM installed_apps WHERE app_idx == $1 AND version == $2;";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, std::to_string(appIdx).c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, version.c_str(), -1, SQLITE_TRANSIENT);
         ExecuteSqlStep(stmt);
-        sqlite3_finalize(stmt);
+        connection.invalidate();
     }
 
     void SqlDataStorage::DeleteFromApps(const std::string &type,
                                         const std::string &id)
     {
 
-        std::string query = "DELETE FROM apps WHERE type == $1 AND app_id == $2;";
-        sqlite3_stmt *stmt;
-        sqlite3_prepare_v2(sqlite, query.c_str(), query.length(), &stmt, nullptr);
+        static const std::string query = "DELETE FROM apps WHERE type == $1 AND app_id == $2;";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
 
         sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
         ExecuteSqlStep(stmt);
-        sqlite3_finalize(stmt);
+        connection.invalidate();
+    }
+
+    int SqlDataStorage::GetInstalledAppIdx(const std::string &type,
+                                           const std::string &id,
+                                           const std::string &version)
+    {
+        static const std::string query = "SELECT installed_apps.idx FROM installed_apps "
+                                         "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
+                                         "WHERE (?1 IS NULL OR type = ?1) AND app_id = ?2 AND version = ?3";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, version.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_ROW)
+        {
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        int installedAppIdx = sqlite3_column_int(stmt, 0);
+        return installedAppIdx;
+    }
+
+    void SqlDataStorage::DeleteFromAppFiles(const std::string &type,
+                                            const std::string &id,
+                                            const std::string &version)
+    {
+        static const std::string query = "DELETE FROM app_files "
+                                         "WHERE installed_app_idx IN ("
+                                         "SELECT installed_apps.idx FROM installed_apps "
+                                         "INNER JOIN apps ON apps.idx = installed_apps.app_idx "
+                                         "WHERE (?1 IS NULL OR type = ?1) AND app_id = ?2 AND version = ?3);";
+        auto connection = connections.writer();
+        StatementCache::Statement stmt{connection.statements(), query};
+
+        sqlite3_bind_text(stmt, 1, type.empty() ? nullptr : type.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, version.c_str(), -1, SQLITE_TRANSIENT);
+        ExecuteSqlStep(stmt);
     }
 
     void SqlDataStorage::ExecuteSqlStep(sqlite3_stmt *stmt)
@@ -627,8 +1138,7 @@ namespace packagemanager
 
         if (sqlite3_step(stmt) != SQLITE_DONE)
         {
-            sqlite3_finalize(stmt);
-            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite));
+            throw SqlDataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(sqlite3_db_handle(stmt)));
         }
     }
 } // namespace packagemanagere
@@ -0,0 +1,99 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StatementCache.h"
+#include "DataStorage.h"
+
+namespace packagemanager
+{
+
+    StatementCache::~StatementCache()
+    {
+        finalizeAll();
+    }
+
+    void StatementCache::reset(sqlite3 *newConnection)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finalizeAll();
+        connection = newConnection;
+    }
+
+    sqlite3_stmt *StatementCache::acquire(const std::string &query)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = statements.find(query);
+        if (it != statements.end() && !it->second.inUse)
+        {
+            it->second.inUse = true;
+            return it->second.stmt;
+        }
+
+        // only the first statement of a query is kept
+        const bool keep = it == statements.end();
+        sqlite3_stmt *stmt{nullptr};
+        if (sqlite3_prepare_v3(connection, query.c_str(), query.length(), keep ? SQLITE_PREPARE_PERSISTENT : 0, &stmt, nullptr) != SQLITE_OK)
+        {
+            sqlite3_finalize(stmt);
+            throw DataStorageError(std::string{"sqlite error: "} + sqlite3_errmsg(connection));
+        }
+        if (keep)
+        {
+            statements.emplace(query, Entry{stmt, true});
+        }
+        return stmt;
+    }
+
+    void StatementCache::release(sqlite3_stmt *stmt)
+    {
+        if (!stmt)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = statements.find(sqlite3_sql(stmt));
+        if (it != statements.end() && it->second.stmt == stmt)
+        {
+            // ends the read transaction of a SELECT that was not stepped to the end
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            it->second.inUse = false;
+        }
+        else
+        {
+            sqlite3_finalize(stmt);
+        }
+    }
+
+    std::size_t StatementCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return statements.size();
+    }
+
+    void StatementCache::finalizeAll()
+    {
+        for (auto &statement : statements)
+        {
+            sqlite3_finalize(statement.second.stmt);
+        }
+        statements.clear();
+    }
+
+} // namespace packagemanager
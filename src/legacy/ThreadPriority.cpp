@@ -0,0 +1,158 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadPriority.h"
+
+#include "Debug.h"
+
+#include <cerrno>
+#include <linux/capability.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace packagemanager
+{
+    namespace
+    { // anonymous
+
+        // ioprio_get() and ioprio_set() have no glibc wrapper
+        constexpr int IOPRIO_WHO_PROCESS = 1;
+        constexpr int IOPRIO_CLASS_BE = 2;
+        constexpr int IOPRIO_CLASS_IDLE = 3;
+        constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+        id_t currentThreadId()
+        {
+            return static_cast<id_t>(syscall(SYS_gettid));
+        }
+
+        int ioPriorityValue(const PriorityProfile &profile)
+        {
+            // the idle class has no levels
+            if (profile.ioClass == IoClass::IDLE)
+            {
+                return IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+            }
+            return (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | (profile.ioLevel & 7);
+        }
+
+        bool setIoPriority(id_t tid, int value)
+        {
+            return syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, value) == 0;
+        }
+
+        bool hasSysNice()
+        {
+            // capget() has no glibc wrapper either
+            __user_cap_header_struct header{_LINUX_CAPABILITY_VERSION_3, 0};
+            __user_cap_data_struct data[_LINUX_CAPABILITY_U32S_3]{};
+            if (syscall(SYS_capget, &header, data) != 0)
+            {
+                return false;
+            }
+            return (data[CAP_TO_INDEX(CAP_SYS_NICE)].effective & CAP_TO_MASK(CAP_SYS_NICE)) != 0;
+        }
+
+        // An unprivileged thread may lower its nice value only down to 20 - RLIMIT_NICE.
+        bool canLowerNiceTo(int nice)
+        {
+            struct rlimit limit;
+            if (getrlimit(RLIMIT_NICE, &limit) == 0 &&
+                (limit.rlim_cur == RLIM_INFINITY || 20 - static_cast<int>(limit.rlim_cur) <= nice))
+            {
+                return true;
+            }
+            return hasSysNice();
+        }
+
+    } // namespace anonymous
+
+    namespace ThreadPriority
+    {
+        bool apply(const PriorityProfile &profile)
+        {
+            auto tid = currentThreadId();
+            bool ok{true};
+            if (setpriority(PRIO_PROCESS, tid, profile.nice) != 0)
+            {
+                WARNING("[ThreadPriority] Unable to set nice value ", profile.nice);
+                ok = false;
+            }
+            if (!setIoPriority(tid, ioPriorityValue(profile)))
+            {
+                WARNING("[ThreadPriority] Unable to set io priority");
+                ok = false;
+            }
+            return ok;
+        }
+    } // namespace ThreadPriority
+
+    ScopedThreadPriority::ScopedThreadPriority(const PriorityProfile &profile)
+    {
+        if (!profile.enabled)
+        {
+            return;
+        }
+        auto tid = currentThreadId();
+        previousIoPriority = static_cast<int>(syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, tid));
+        errno = 0;
+        previousNice = getpriority(PRIO_PROCESS, tid);
+        if (previousIoPriority < 0 || (previousNice == -1 && errno != 0))
+        {
+            WARNING("[ScopedThreadPriority] Unable to read the thread priority, not changed");
+            return;
+        }
+        applied = true;
+        // the caller's thread must not stay niced after the job, so only raise the nice
+        // value if it can be lowered back again
+        niced = profile.nice != previousNice && (profile.nice < previousNice || canLowerNiceTo(previousNice));
+        if (niced && setpriority(PRIO_PROCESS, tid, profile.nice) != 0)
+        {
+            WARNING("[ScopedThreadPriority] Unable to set nice value ", profile.nice);
+            niced = false;
+        }
+        else if (!niced && profile.nice != previousNice)
+        {
+            DEBUG("[ScopedThreadPriority] Keeping nice value ", previousNice, ", it could not be restored");
+        }
+        if (!setIoPriority(tid, ioPriorityValue(profile)))
+        {
+            WARNING("[ScopedThreadPriority] Unable to set io priority");
+        }
+    }
+
+    ScopedThreadPriority::~ScopedThreadPriority()
+    {
+        if (!applied)
+        {
+            return;
+        }
+        auto tid = currentThreadId();
+        if (niced && setpriority(PRIO_PROCESS, tid, previousNice) != 0)
+        {
+            WARNING("[ScopedThreadPriority] Unable to restore nice value ", previousNice);
+        }
+        if (!setIoPriority(tid, previousIoPriority))
+        {
+            WARNING("[ScopedThreadPriority] Unable to restore io priority");
+        }
+    }
+
+} // namespace packagemanager
@@ -0,0 +1,147 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TrashReaper.h"
+
+#include "Debug.h"
+#include "Filesystem.h"
+#include "ThreadPriority.h"
+
+#include <chrono>
+
+namespace packagemanager
+{
+    namespace
+    { // anonymous
+
+        // deleting is never urgent, whatever the configured background priority
+        const PriorityProfile REAPER_PRIORITY{true, IoClass::IDLE, 7, 19};
+
+    } // namespace anonymous
+
+    TrashReaper::TrashReaper(const std::string &trashPath) : trashPath(trashPath)
+    {
+    }
+
+    TrashReaper::~TrashReaper()
+    {
+        {
+            // under the mutex, run() could otherwise miss the notification between its check and its wait
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        condition.notify_all();
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    void TrashReaper::start()
+    {
+        Filesystem::createDirectory(trashPath);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // resume whatever was left behind by a previous run
+            workPending = true;
+            idle = false;
+        }
+        thread = std::thread(&TrashReaper::run, this);
+    }
+
+    void TrashReaper::wakeUp()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            workPending = true;
+            idle = false;
+        }
+        condition.notify_one();
+    }
+
+    std::string TrashReaper::createTrashPath(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        return trashPath + name + '.' + std::to_string(stamp) + '.' + std::to_string(++trashCounter);
+    }
+
+    void TrashReaper::waitUntilIdle()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        emptyCondition.wait(lock, [this]
+                            { return idle || stopRequested; });
+    }
+
+    void TrashReaper::run()
+    {
+        ThreadPriority::apply(REAPER_PRIORITY);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopRequested)
+        {
+            condition.wait(lock, [this]
+                           { return workPending || stopRequested; });
+            if (stopRequested)
+            {
+                break;
+            }
+            workPending = false;
+
+            lock.unlock();
+            if (!reap() && !stopRequested)
+            {
+                WARNING("[TrashReaper] Trash could not be emptied completely");
+            }
+            lock.lock();
+
+            if (!workPending)
+            {
+                idle = true;
+                emptyCondition.notify_all();
+            }
+        }
+        idle = true;
+        emptyCondition.notify_all();
+    }
+
+    bool TrashReaper::reap()
+    {
+        bool complete{true};
+        try
+        {
+            for (const auto &entry : Filesystem::getSubdirectories(trashPath))
+            {
+                if (stopRequested)
+                {
+                    return false;
+                }
+                DEBUG("[TrashReaper] removing ", entry);
+                complete = Filesystem::removeDirectoryTree(trashPath + entry, &stopRequested) && complete;
+            }
+        }
+        catch (std::exception &error)
+        {
+            ERROR("[TrashReaper] Unable to empty trash: ", error.what());
+            complete = false;
+        }
+        return complete;
+    }
+
+} // namespace packagemanager
@@ -0,0 +1,217 @@
+/*
+ * If not stated otherwise in this file or this component's LICENSE file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2025 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TreeWalker.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace packagemanager
+{
+    namespace Filesystem
+    {
+
+        namespace
+        { // anonymous
+
+            // bounded, the walk is I/O bound and should not starve app launches
+            constexpr unsigned int MAX_WALKER_THREADS = 4;
+
+            class Walk
+            {
+            public:
+                Walk(const std::string &root, const TreeWalker::Visitor &visitor,
+                     const std::atomic<bool> *cancel, unsigned int threads)
+                    : root(root), visitor(visitor), cancel(cancel), maxThreads(threads)
+                {
+                    pending.push_back(std::string{});
+                }
+
+                bool run()
+                {
+                    work();
+                    // helpers are only started while there is work left, none is started after work() returned
+                    for (auto &helper : helpers)
+                    {
+                        helper.join();
+                    }
+                    return complete;
+                }
+
+            private:
+                void work()
+                {
+                    while (true)
+                    {
+                        std::string dirPath;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            condition.wait(lock, [this]
+                            {
+                                return !pending.empty() || active == 0;
+                            });
+                            if (pending.empty())
+                            {
+                                return;
+                            }
+                            dirPath = std::move(pending.front());
+                            pending.pop_front();
+                            ++active;
+                        }
+
+                        readDirectory(dirPath);
+
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (--active == 0 && pending.empty())
+                        {
+                            condition.notify_all();
+                        }
+                    }
+                }
+
+                void schedule(std::string dirPath)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending.push_back(std::move(dirPath));
+                    if (pending.size() > 1 && helpers.size() + 1 < maxThreads)
+                    {
+                        helpers.emplace_back(&Walk::work, this);
+                    }
+                    condition.notify_one();
+                }
+
+                bool cancelled() const
+                {
+                    return cancel && cancel->load();
+                }
+
+                void readDirectory(const std::string &dirPath)
+                {
+                    // the root may be a symlink to a directory, nothing below it is followed
+                    int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | (dirPath.empty() ? 0 : O_NOFOLLOW);
+                    int dirFd = open((root + dirPath).c_str(), flags);
+                    DIR *dir = dirFd < 0 ? nullptr : fdopendir(dirFd);
+                    if (!dir)
+                    {
+                        ERROR("Could not read directory ", root, dirPath, " error: ", strerror(errno));
+                        if (dirFd >= 0)
+                        {
+                            close(dirFd);
+                        }
+                        complete = false;
+                        return;
+                    }
+
+                    struct dirent *dirEntry{};
+                    while ((dirEntry = readdir(dir)) != nullptr)
+                    {
+                        if (cancelled())
+                        {
+                            complete = false;
+                            break;
+                        }
+                        const char *name = dirEntry->d_name;
+                        if (!strcmp(name, ".") || !strcmp(name, ".."))
+                        {
+                            continue;
+                        }
+
+                        struct stat st{};
+                        if (dirEntry->d_type == DT_DIR)
+                        {
+                            st.st_mode = S_IFDIR;
+                        }
+                        else if (fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                        {
+                            if (errno != ENOENT)
+                            {
+                                ERROR("Could not stat ", root, dirPath, name, " error: ", strerror(errno));
+                                complete = false;
+                            }
+                            continue;
+                        }
+
+                        bool isDirectory = S_ISDIR(st.st_mode);
+                        try
+                        {
+                            visitor(TreeWalker::Entry{dirFd, name, dirPath, isDirectory, st});
+                        }
+                        catch (std::exception &error)
+                        {
+                            ERROR("Visiting ", root, dirPath, name, " failed: ", error.what());
+                            complete = false;
+                        }
+
+                        if (isDirectory)
+                        {
+                            schedule(dirPath + name + '/');
+                        }
+                    }
+                    closedir(dir);
+                }
+
+                const std::string &root;
+                const TreeWalker::Visitor &visitor;
+                const std::atomic<bool> *cancel;
+                const unsigned int maxThreads;
+
+                std::mutex mutex{};
+                std::condition_variable condition{};
+                std::deque<std::string> pending{};
+                std::vector<std::thread> helpers{};
+                unsigned int active{0};
+                std::atomic<bool> complete{true};
+            };
+
+        } // namespace anonymous
+
+        TreeWalker::TreeWalker(unsigned int threads)
+            : threads(std::max(1u, threads))
+        {
+        }
+
+        unsigned int TreeWalker::defaultThreads()
+        {
+            return std::max(1u, std::min(std::thread::hardware_concurrency(), MAX_WALKER_THREADS));
+        }
+
+        bool TreeWalker::walk(const std::string &root, const Visitor &visitor, const std::atomic<bool> *cancel) const
+        {
+            std::string rootPath = root;
+            if (rootPath.empty() || rootPath.back() != '/')
+            {
+                rootPath += '/';
+            }
+            Walk walk(rootPath, visitor, cancel, threads);
+            return walk.run();
+        }
+
+    } // namespace Filesystem
+} // namespace packagemanager
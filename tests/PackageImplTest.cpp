@@ -20,12 +20,78 @@
 #include <gtest/gtest.h>
 #include "PackageImpl.h"
 #include "IPackageImpl.h"
+#include "CatalogQueries.h"
+#include "CatalogSnapshot.h"
+#include "Config.h"
+#include "ConnectionPool.h"
+#include "Digest.h"
+#include "IoScheduler.h"
+#include "Journal.h"
+#include "LockRegistry.h"
+#include "SingleFlight.h"
+#include "SqlDataStorage.h"
+#include "StatementCache.h"
+#include "ThreadPriority.h"
+#include "TrashReaper.h"
 #include <gmock/gmock.h>
 #include <sqlite3.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cstdlib>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <thread>
+#include <unistd.h>
 
 class PackageImplTest : public ::testing::Test
 {
 protected:
+    void SetUp() override
+    {
+        // a directory of its own, nothing is left behind for the next test or run
+        ASSERT_EQ(system("mkdir -p /tmp/opt"), 0);
+        char path[] = "/tmp/opt/test.XXXXXX";
+        ASSERT_NE(mkdtemp(path), nullptr);
+        testRoot = path;
+    }
+
+    void TearDown() override
+    {
+        if (!testRoot.empty())
+        {
+            EXPECT_EQ(system(("rm -rf " + testRoot).c_str()), 0);
+        }
+    }
+
+    // Config with all paths in testRoot, extra is appended to its members, e.g. R"(,"watchAppsPath":true)"
+    std::string configFor(const std::string &extra = "") const
+    {
+        return R"({"appspath":")" + testRoot + R"(/apps","dbpath":")" + testRoot + R"(","datapath":")" + testRoot +
+               R"(/data","annotationsFile":"config.json","annotationsRegex":"public\\.*","downloadRetryAfterSeconds":30,"downloadRetryMaxTimes":4,"downloadTimeoutSeconds":900)" +
+               extra + "}";
+    }
+
+    // Catalog in testRoot, opened without integrity check
+    std::unique_ptr<packagemanager::SqlDataStorage> openStorage() const
+    {
+        std::unique_ptr<packagemanager::SqlDataStorage> storage{new packagemanager::SqlDataStorage{testRoot + "/"}};
+        storage->Initialize(packagemanager::DataStorage::IntegrityCheck::NONE);
+        return storage;
+    }
+
+    // Records the version as installed, named after the last part of the id
+    void addApp(packagemanager::DataStorage &storage, const std::string &id, const std::string &version,
+                const std::string &category = "", const std::string &volume = "") const
+    {
+        storage.AddInstalledApp(APP_TYPE, id, version, "", id.substr(id.rfind('.') + 1), category, id + '/' + version, id, volume);
+    }
+
+    const std::string APP_TYPE{"application/vnd.rdk-app.dac.native"};
+    std::string testRoot;
     packagemanager::PackageImpl packageImpl;
 };
 
@@ -135,3 +201,961 @@ TEST_F(PackageImplTest, GetFileMetadataHandlesEmptyPackageId) {
     auto result = packageImpl.GetFileMetadata(fileLocator, emptyPackageId, version, configMetadata);
     EXPECT_EQ(result, packagemanager::Result::FAILED);
 }
+
+TEST_F(PackageImplTest, UninstallDeferredWhileLocked)
+{
+    std::string configStr = configFor();
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string dbPath = testRoot + "/0/apps.db";
+    sqlite3 *db;
+    ASSERT_EQ(sqlite3_open(dbPath.c_str(), &db), SQLITE_OK);
+    const char *insertQuery = R"(
+        INSERT INTO apps (type, app_id, data_path, created)
+        VALUES ('application/dac.native', 'com.rdk.locked', '0/com.rdk.locked/', 'Wed Apr 30 14:05:16 2025');
+        INSERT INTO installed_apps (app_idx, version, name, category, url, app_path, created, resources, metadata)
+        VALUES ((SELECT idx FROM apps WHERE app_id = 'com.rdk.locked'), '1.0', 'lockedapp', 'category', '',
+                '0/com.rdk.locked/1.0/', 'Wed Apr 30 14:05:16 2025', NULL, NULL);
+    )";
+    ASSERT_EQ(sqlite3_exec(db, insertQuery, nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(db);
+
+    std::string appPath = testRoot + "/apps/0/com.rdk.locked/1.0";
+    ASSERT_EQ(system(("mkdir -p " + appPath).c_str()), 0);
+    std::ofstream(appPath + "/config.json") << R"({"process":{"args":["/bin/true"]}})";
+
+    std::string unpackedPath;
+    packagemanager::ConfigMetaData confMetadata;
+    packagemanager::NameValues additionalLocks;
+    ASSERT_EQ(packageImpl.Lock("com.rdk.locked", "1.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+    ASSERT_EQ(packageImpl.Lock("com.rdk.locked", "1.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+
+    // uninstall is accepted but deferred while the app is locked
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.locked"), packagemanager::Result::SUCCESS);
+    EXPECT_TRUE(std::ifstream(appPath + "/config.json").good());
+
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.locked", "1.0"), packagemanager::Result::SUCCESS);
+    EXPECT_TRUE(std::ifstream(appPath + "/config.json").good());
+
+    // last unlock runs the deferred uninstall
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.locked", "1.0"), packagemanager::Result::SUCCESS);
+    EXPECT_FALSE(std::ifstream(appPath + "/config.json").good());
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.locked", "1.0"), packagemanager::Result::FAILED);
+}
+
+TEST_F(PackageImplTest, LockFailsWhileUninstalling)
+{
+    packagemanager::LockRegistry registry;
+    unsigned int remaining{};
+
+    // an unlocked version is blocked in the same step, until the removal is done
+    using BlockReason = packagemanager::LockRegistry::BlockReason;
+    BlockReason blockedBy{};
+    EXPECT_FALSE(registry.deferUninstallOrBlock("com.rdk.app", "1.0", {"type", "full"}));
+    EXPECT_EQ(registry.lock("com.rdk.app", "1.0", &blockedBy), 0u);
+    EXPECT_EQ(blockedBy, BlockReason::UNINSTALL);
+    registry.unblock("com.rdk.app", "1.0");
+    EXPECT_EQ(registry.lock("com.rdk.app", "1.0", &blockedBy), 1u);
+    EXPECT_EQ(blockedBy, BlockReason::NONE);
+
+    // a locked version parks the uninstall and stays blocked while the parked one runs
+    EXPECT_TRUE(registry.deferUninstallOrBlock("com.rdk.app", "1.0", {"type", "full"}));
+    ASSERT_TRUE(registry.unlock("com.rdk.app", "1.0", remaining));
+    packagemanager::LockRegistry::DeferredUninstall uninstall;
+    ASSERT_TRUE(registry.takeDeferredUninstall("com.rdk.app", "1.0", uninstall));
+    EXPECT_EQ(uninstall.uninstallType, "full");
+    EXPECT_EQ(registry.lock("com.rdk.app", "1.0"), 0u);
+    registry.unblock("com.rdk.app", "1.0");
+    EXPECT_FALSE(registry.takeDeferredUninstall("com.rdk.app", "1.0", uninstall));
+    EXPECT_EQ(registry.lock("com.rdk.app", "1.0"), 1u);
+
+    // an eviction reports itself, not as an uninstall
+    ASSERT_TRUE(registry.unlock("com.rdk.app", "1.0", remaining));
+    EXPECT_TRUE(registry.blockIfUnlocked("com.rdk.app", "1.0", BlockReason::EVICTION));
+    EXPECT_EQ(registry.lock("com.rdk.app", "1.0", &blockedBy), 0u);
+    EXPECT_EQ(blockedBy, BlockReason::EVICTION);
+    registry.unblock("com.rdk.app", "1.0");
+}
+
+TEST_F(PackageImplTest, TrashReaperEmptiesTrash)
+{
+    const std::string trashPath{testRoot + "/trash/"};
+    // left behind by a previous run
+    ASSERT_EQ(system(("mkdir -p " + trashPath + "old.1/bin && touch " + trashPath + "old.1/bin/app").c_str()), 0);
+    {
+        packagemanager::TrashReaper reaper{trashPath};
+        reaper.start();
+        reaper.waitUntilIdle();
+        EXPECT_NE(access((trashPath + "old.1").c_str(), F_OK), 0);
+
+        ASSERT_EQ(system(("mkdir -p " + testRoot + "/trashed/lib && touch " + testRoot + "/trashed/lib/libapp.so").c_str()), 0);
+        auto target = reaper.createTrashPath("com.rdk.app_1.0");
+        ASSERT_EQ(rename((testRoot + "/trashed").c_str(), target.c_str()), 0);
+        reaper.wakeUp();
+        reaper.waitUntilIdle();
+        EXPECT_NE(access(target.c_str(), F_OK), 0);
+    }
+
+    // stopping right after a wake up must not hang
+    for (int i = 0; i < 50; ++i)
+    {
+        packagemanager::TrashReaper reaper{trashPath};
+        reaper.start();
+        reaper.wakeUp();
+    }
+}
+
+TEST_F(PackageImplTest, InstallPublishesExtractedApp)
+{
+    std::string configStr = configFor();
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string bundlePath = testRoot + "/bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath + "/bin").c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << R"({"process":{"args":["bin/app"]}})";
+    std::ofstream(bundlePath + "/bin/app") << "#!/bin/sh";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::NameValues additionalMetadata = {{"type", "application/dac.native"}, {"appName", "staged"}};
+    packagemanager::ConfigMetaData confMetadata;
+    ASSERT_EQ(packageImpl.Install("com.rdk.staged", "2.0", additionalMetadata, testRoot + "/bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    std::string appPath = testRoot + "/apps/0/com.rdk.staged/2.0";
+    EXPECT_TRUE(std::ifstream(appPath + "/bin/app").good());
+    EXPECT_FALSE(std::ifstream(testRoot + "/apps/tmp/0/com.rdk.staged/2.0/bin/app").good());
+
+    // the same version can not be published twice from a different archive
+    ASSERT_EQ(system(("tar czf " + testRoot + "/bundle_other.tar.gz -C " + bundlePath + " bin").c_str()), 0);
+    EXPECT_EQ(packageImpl.Install("com.rdk.staged", "2.0", additionalMetadata, testRoot + "/bundle_other.tar.gz", confMetadata), packagemanager::Result::FAILED);
+
+    std::string unpackedPath;
+    packagemanager::NameValues additionalLocks;
+    ASSERT_EQ(packageImpl.Lock("com.rdk.staged", "2.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(unpackedPath, testRoot + "/apps/0/com.rdk.staged/2.0/");
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.staged", "2.0"), packagemanager::Result::SUCCESS);
+
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.staged"), packagemanager::Result::SUCCESS);
+    EXPECT_FALSE(std::ifstream(appPath + "/bin/app").good());
+}
+
+TEST_F(PackageImplTest, InitializeRecoversInterruptedInstall)
+{
+    std::string configStr = configFor();
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    // published tree of an install that never reached the catalog
+    std::string crashedPath = testRoot + "/apps/0/com.rdk.crashed/1.0";
+    ASSERT_EQ(system(("mkdir -p " + crashedPath).c_str()), 0);
+    std::ofstream(crashedPath + "/config.json") << "{}";
+    std::ofstream(testRoot + "/0/journal", std::ios::app) << "B 7 I com.rdk.crashed 1.0\n";
+
+    // not mentioned in the journal, a clean start does not scan for it
+    std::string untouchedPath = testRoot + "/apps/0/com.rdk.untouched/1.0";
+    ASSERT_EQ(system(("mkdir -p " + untouchedPath).c_str()), 0);
+    std::ofstream(untouchedPath + "/config.json") << "{}";
+
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+    EXPECT_FALSE(std::ifstream(crashedPath + "/config.json").good());
+    EXPECT_TRUE(std::ifstream(untouchedPath + "/config.json").good());
+
+    std::ifstream journal(testRoot + "/0/journal");
+    EXPECT_TRUE(journal.good());
+    EXPECT_EQ(journal.peek(), std::ifstream::traits_type::eof());
+}
+
+TEST_F(PackageImplTest, JournalStaysDirtyUntilReset)
+{
+    std::string path = testRoot + "/journal";
+    std::vector<packagemanager::Journal::Entry> incomplete;
+    bool cleanShutdown{false};
+    {
+        packagemanager::Journal journal(path);
+        journal.open(incomplete, cleanShutdown);
+        journal.markDirty();
+        // the commit truncates the journal once nothing is in flight
+        journal.commit(journal.begin(packagemanager::Journal::Operation::INSTALL, "com.rdk.during", "1.0"));
+        journal.markCleanShutdown();
+    }
+    {
+        packagemanager::Journal journal(path);
+        EXPECT_FALSE(journal.open(incomplete, cleanShutdown));
+        EXPECT_TRUE(incomplete.empty());
+        journal.reset();
+        journal.markCleanShutdown();
+    }
+    packagemanager::Journal journal(path);
+    EXPECT_TRUE(journal.open(incomplete, cleanShutdown));
+    EXPECT_TRUE(cleanShutdown);
+}
+
+TEST_F(PackageImplTest, JournalEntryCommitsOnException)
+{
+    std::string path = testRoot + "/journal";
+    std::vector<packagemanager::Journal::Entry> incomplete;
+    bool cleanShutdown{false};
+    {
+        packagemanager::Journal journal(path);
+        journal.open(incomplete, cleanShutdown);
+        try
+        {
+            packagemanager::Journal::ScopedEntry entry{journal, packagemanager::Journal::Operation::INSTALL, "com.rdk.failed", "1.0"};
+            throw std::runtime_error("publishing failed");
+        }
+        catch (std::runtime_error &)
+        {
+        }
+        journal.markCleanShutdown();
+    }
+    packagemanager::Journal journal(path);
+    EXPECT_TRUE(journal.open(incomplete, cleanShutdown));
+    EXPECT_TRUE(incomplete.empty());
+    EXPECT_TRUE(cleanShutdown);
+}
+
+TEST_F(PackageImplTest, LazyStartupKeepsCatalogUsable)
+{
+    std::string configStr = configFor(R"(,"startupMode":"lazy")");
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string bundlePath = testRoot + "/bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath).c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << "{}";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::NameValues additionalMetadata = {{"type", "application/dac.native"}, {"appName", "lazy"}};
+    packagemanager::ConfigMetaData confMetadata;
+    ASSERT_EQ(packageImpl.Install("com.rdk.lazy", "1.0", additionalMetadata, testRoot + "/bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    // the second start trusts the journal and only runs the quick check before returning
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string unpackedPath;
+    packagemanager::NameValues additionalLocks;
+    ASSERT_EQ(packageImpl.Lock("com.rdk.lazy", "1.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(unpackedPath, testRoot + "/apps/0/com.rdk.lazy/1.0/");
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.lazy", "1.0"), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.lazy"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, DirectoryHelpersHandleNestedTree)
+{
+    std::string root = testRoot + "/walk";
+    for (int i = 0; i < 8; ++i)
+    {
+        std::string dir = root + "/dir" + std::to_string(i) + "/sub";
+        ASSERT_EQ(system(("mkdir -p " + dir).c_str()), 0);
+        std::ofstream(dir + "/file") << std::string(100, 'x');
+    }
+    std::ofstream(root + "/top") << std::string(24, 'x');
+    ASSERT_EQ(symlink((root + "/top").c_str(), (root + "/link").c_str()), 0);
+
+    auto usage = packagemanager::Filesystem::getDirectoryUsage(root);
+    EXPECT_EQ(usage.size, 8 * 100 + 24);
+    EXPECT_GT(usage.blocks, 0u);
+    EXPECT_EQ(packagemanager::Filesystem::getDirectorySpace(root), usage.size);
+
+    auto manifest = packagemanager::Filesystem::getDirectoryManifest(root);
+    ASSERT_EQ(manifest.size(), 9u);
+    EXPECT_EQ(manifest.front().path, "dir0/sub/file");
+    EXPECT_EQ(manifest.back().path, "top");
+
+    packagemanager::Filesystem::removeDirectory(root);
+    EXPECT_FALSE(packagemanager::Filesystem::directoryExists(root));
+    EXPECT_NO_THROW(packagemanager::Filesystem::removeDirectory(root));
+}
+
+TEST_F(PackageImplTest, WatchedAppsPathRemovesOrphansOnMaintenance)
+{
+    std::string configStr = configFor(R"(,"watchAppsPath":true)");
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    // appears after the watcher listed the tree, only known from its events
+    std::string orphanPath = testRoot + "/apps/0/com.rdk.orphan/1.0";
+    ASSERT_EQ(system(("mkdir -p " + orphanPath).c_str()), 0);
+    std::ofstream(orphanPath + "/config.json") << "{}";
+
+    std::string bundlePath = testRoot + "/bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath).c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << "{}";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::NameValues additionalMetadata = {{"type", "application/dac.native"}, {"appName", "watched"}};
+    packagemanager::ConfigMetaData confMetadata;
+    ASSERT_EQ(packageImpl.Install("com.rdk.watched", "1.0", additionalMetadata, testRoot + "/bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    EXPECT_FALSE(std::ifstream(orphanPath + "/config.json").good());
+    EXPECT_TRUE(std::ifstream(testRoot + "/apps/0/com.rdk.watched/1.0/config.json").good());
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.watched"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, InstallPlacesRarelyUsedAppsOnSlowVolume)
+{
+    ASSERT_EQ(system(("mkdir -p " + testRoot + "/usb").c_str()), 0);
+    std::string configStr = configFor(R"(,"appVolumes":[{"name":"usb","path":")" + testRoot + R"(/usb","speed":"slow"},{"name":"missing","path":")" + testRoot + R"(/missing","speed":"slow"}])");
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+    EXPECT_FALSE(packagemanager::Filesystem::directoryExists(testRoot + "/missing"));
+
+    std::string bundlePath = testRoot + "/bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath).c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << "{}";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::ConfigMetaData confMetadata;
+    packagemanager::NameValues rareMetadata = {{"type", "application/dac.native"}, {"appName", "rare"}, {"usageHint", "rare"}};
+    ASSERT_EQ(packageImpl.Install("com.rdk.rare", "1.0", rareMetadata, testRoot + "/bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+    packagemanager::NameValues hotMetadata = {{"type", "application/dac.native"}, {"appName", "hot"}};
+    ASSERT_EQ(packageImpl.Install("com.rdk.hot", "1.0", hotMetadata, testRoot + "/bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    EXPECT_TRUE(std::ifstream(testRoot + "/usb/0/com.rdk.rare/1.0/config.json").good());
+    EXPECT_TRUE(std::ifstream(testRoot + "/apps/0/com.rdk.hot/1.0/config.json").good());
+
+    std::string unpackedPath;
+    packagemanager::NameValues additionalLocks;
+    ASSERT_EQ(packageImpl.Lock("com.rdk.rare", "1.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(unpackedPath, testRoot + "/usb/0/com.rdk.rare/1.0/");
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.rare", "1.0"), packagemanager::Result::SUCCESS);
+
+    // a restart keeps the app on the volume
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+    EXPECT_TRUE(std::ifstream(testRoot + "/usb/0/com.rdk.rare/1.0/config.json").good());
+
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.rare"), packagemanager::Result::SUCCESS);
+    EXPECT_FALSE(std::ifstream(testRoot + "/usb/0/com.rdk.rare/1.0/config.json").good());
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.hot"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, InvalidAppVolumeIsSkipped)
+{
+    packagemanager::Config config{R"({"appspath":"/tmp/opt/dac_apps/apps","appVolumes":[{"path":"/tmp/opt/nameless"},{"name":"pathless"},{"name":"usb","path":"/tmp/opt/usb","speed":"fast"}],"evictionPolicy":"lru"})"};
+
+    ASSERT_EQ(config.getAppVolumes().size(), 2u);
+    EXPECT_EQ(config.getAppVolumes()[1].name, "usb");
+    EXPECT_EQ(config.getAppVolumes()[1].speed, packagemanager::VolumeSpeed::FAST);
+    // the keys after the invalid entries are still read
+    EXPECT_EQ(config.getEvictionPolicy(), packagemanager::EvictionPolicy::LRU);
+}
+
+TEST_F(PackageImplTest, EvictionPlanListsOnlyUnlockedVersions)
+{
+    ASSERT_EQ(system(("mkdir -p " + testRoot + "/usb").c_str()), 0);
+    std::string configStr = configFor(R"(,"evictionPolicy":"lru","evictSupersededOnly":false,"appVolumes":[{"name":"usb","path":")" + testRoot + R"(/usb","speed":"slow","capacityMB":1}])");
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string bundlePath = testRoot + "/evict_bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath).c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << "{}";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/evict_bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::ConfigMetaData confMetadata;
+    packagemanager::NameValues metadata = {{"type", "application/dac.native"}, {"appName", "cold"}, {"usageHint", "rare"}};
+    ASSERT_EQ(packageImpl.Install("com.rdk.cold", "1.0", metadata, testRoot + "/evict_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+    ASSERT_EQ(packageImpl.Install("com.rdk.cold", "2.0", metadata, testRoot + "/evict_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    std::string unpackedPath;
+    packagemanager::NameValues additionalLocks;
+    ASSERT_EQ(packageImpl.Lock("com.rdk.cold", "2.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+
+    // both versions use 2 bytes of the 1MB capacity, 2 bytes less than that only fit with one of them gone
+    packagemanager::NameValues plan;
+    ASSERT_EQ(packageImpl.GetEvictionPlan(1024 * 1024 - 2, "rare", plan), packagemanager::Result::SUCCESS);
+    ASSERT_EQ(plan.size(), 1u);
+    EXPECT_EQ(plan[0].first, "com.rdk.cold");
+    EXPECT_EQ(plan[0].second, "1.0");
+
+    // a dry run removes nothing
+    EXPECT_TRUE(std::ifstream(testRoot + "/usb/0/com.rdk.cold/1.0/config.json").good());
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.cold", "2.0"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, LockRehydratesHibernatedApp)
+{
+    std::string configStr = configFor(R"(,"hibernateAfterSeconds":1)");
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string bundlePath = testRoot + "/hibernate_bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath + "/bin").c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << R"({"process":{"args":["/bin/app"]}})";
+    std::ofstream(bundlePath + "/bin/app") << std::string(64 * 1024, 'x');
+    ASSERT_EQ(system(("tar czf " + testRoot + "/hibernate_bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::ConfigMetaData confMetadata;
+    packagemanager::NameValues metadata = {{"type", "application/dac.native"}, {"appName", "sleepy"}};
+    ASSERT_EQ(packageImpl.Install("com.rdk.sleepy", "1.0", metadata, testRoot + "/hibernate_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    sleep(2);
+    ASSERT_EQ(packageImpl.HibernateIdleApps(), packagemanager::Result::SUCCESS);
+    EXPECT_FALSE(packagemanager::Filesystem::directoryExists(testRoot + "/apps/0/com.rdk.sleepy/1.0"));
+    EXPECT_TRUE(std::ifstream(testRoot + "/apps/hibernated/com.rdk.sleepy_1.0.tar.zst").good());
+
+    // restart: still installed and its metadata available without rehydrating
+    configMetadata.clear();
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(configMetadata.count({"com.rdk.sleepy", "1.0"}), 1u);
+    EXPECT_FALSE(packagemanager::Filesystem::directoryExists(testRoot + "/apps/0/com.rdk.sleepy/1.0"));
+
+    std::string unpackedPath;
+    packagemanager::NameValues additionalLocks;
+    ASSERT_EQ(packageImpl.Lock("com.rdk.sleepy", "1.0", unpackedPath, confMetadata, additionalLocks), packagemanager::Result::SUCCESS);
+    std::ifstream app(unpackedPath + "bin/app");
+    std::string content((std::istreambuf_iterator<char>(app)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content.size(), 64u * 1024u);
+    EXPECT_FALSE(std::ifstream(testRoot + "/apps/hibernated/com.rdk.sleepy_1.0.tar.zst").good());
+
+    // locked versions are never hibernated
+    sleep(2);
+    ASSERT_EQ(packageImpl.HibernateIdleApps(), packagemanager::Result::SUCCESS);
+    EXPECT_TRUE(std::ifstream(unpackedPath + "config.json").good());
+    EXPECT_EQ(packageImpl.Unlock("com.rdk.sleepy", "1.0"), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.sleepy"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, Sha256MatchesReferenceVectors)
+{
+    packagemanager::Digest::Sha256 sha;
+    EXPECT_EQ(sha.finish(), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    sha.reset();
+    std::string message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    // split across the block boundary
+    sha.update(message.data(), 20);
+    sha.update(message.data() + 20, message.size() - 20);
+    EXPECT_EQ(sha.finish(), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    std::ofstream(testRoot + "/million_a") << std::string(1000000, 'a');
+    EXPECT_EQ(packagemanager::Digest::sha256File(testRoot + "/million_a"), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    EXPECT_EQ(packagemanager::Digest::sha256File(testRoot + "/missing_file"), "");
+}
+
+TEST_F(PackageImplTest, SingleFlightCoalescesConcurrentCalls)
+{
+    packagemanager::SingleFlight<std::string, int> flights;
+    std::atomic<int> calls{0};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    auto work = [&]()
+    {
+        ++calls;
+        released.wait();
+        return 42;
+    };
+    auto leader = std::async(std::launch::async, [&]() { return flights.run("app:1.0:digest", work); });
+    while (!flights.inFlight("app:1.0:digest"))
+    {
+        std::this_thread::yield();
+    }
+
+    std::vector<std::future<int>> followers;
+    std::vector<int> shared(4, 0);
+    for (int i = 0; i < 4; ++i)
+    {
+        followers.push_back(std::async(std::launch::async, [&, i]()
+        {
+            bool wasShared = false;
+            int result = flights.run("app:1.0:digest", work, &wasShared);
+            shared[i] = wasShared ? 1 : 0;
+            return result;
+        }));
+    }
+    // a different key is not held up by the flight in progress
+    EXPECT_EQ(flights.run("app:2.0:digest", []() { return 7; }), 7);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    release.set_value();
+    EXPECT_EQ(leader.get(), 42);
+    for (auto &follower : followers)
+    {
+        EXPECT_EQ(follower.get(), 42);
+    }
+    EXPECT_EQ(calls.load(), 1);
+    for (int wasShared : shared)
+    {
+        EXPECT_EQ(wasShared, 1);
+    }
+    EXPECT_FALSE(flights.inFlight("app:1.0:digest"));
+}
+
+TEST_F(PackageImplTest, IdenticalReinstallIsSkippedOrRepaired)
+{
+    std::string configStr = configFor();
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    std::string bundlePath = testRoot + "/digest_bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath + "/bin").c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << R"({"process":{"args":["bin/app"]}})";
+    std::ofstream(bundlePath + "/bin/app") << "#!/bin/sh";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/digest_bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+
+    packagemanager::ConfigMetaData confMetadata;
+    packagemanager::NameValues metadata = {{"type", "application/dac.native"}, {"appName", "digest"}};
+    ASSERT_EQ(packageImpl.Install("com.rdk.digest", "1.0", metadata, testRoot + "/digest_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(packageImpl.Install("com.rdk.digest", "1.0", metadata, testRoot + "/digest_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    // a modified file is only noticed when the caller asks for the content to be verified
+    std::string appPath = testRoot + "/apps/0/com.rdk.digest/1.0/";
+    ASSERT_EQ(chmod((appPath + "bin/app").c_str(), 0644), 0);
+    std::ofstream(appPath + "bin/app") << "corrupted";
+    EXPECT_EQ(packageImpl.Install("com.rdk.digest", "1.0", metadata, testRoot + "/digest_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+    std::ifstream stale(appPath + "bin/app");
+    EXPECT_EQ(std::string((std::istreambuf_iterator<char>(stale)), std::istreambuf_iterator<char>()), "corrupted");
+
+    packagemanager::NameValues verifyMetadata = metadata;
+    verifyMetadata.push_back({"verify", "content"});
+    EXPECT_EQ(packageImpl.Install("com.rdk.digest", "1.0", verifyMetadata, testRoot + "/digest_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+    std::ifstream repaired(appPath + "bin/app");
+    EXPECT_EQ(std::string((std::istreambuf_iterator<char>(repaired)), std::istreambuf_iterator<char>()), "#!/bin/sh");
+
+    // files on an app volume that is gone can not be vouched for
+    sqlite3 *db;
+    ASSERT_EQ(sqlite3_open((testRoot + "/0/apps.db").c_str(), &db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(db, "UPDATE installed_apps SET volume = 'unplugged';", nullptr, nullptr, nullptr), SQLITE_OK);
+    EXPECT_EQ(packageImpl.Install("com.rdk.digest", "1.0", metadata, testRoot + "/digest_bundle.tar.gz", confMetadata), packagemanager::Result::FAILED);
+    ASSERT_EQ(sqlite3_exec(db, "UPDATE installed_apps SET volume = '';", nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(db);
+
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.digest"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, ScopedThreadPriorityIsRestored)
+{
+    auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    auto ioPriority = [tid]() { return static_cast<int>(syscall(SYS_ioprio_get, 1, tid)); };
+    auto nice = [tid]() { return getpriority(PRIO_PROCESS, tid); };
+    const int previousIoPriority = ioPriority();
+    const int previousNice = nice();
+
+    {
+        packagemanager::PriorityProfile disabled{};
+        packagemanager::ScopedThreadPriority scopedPriority{disabled};
+        EXPECT_EQ(ioPriority(), previousIoPriority);
+        EXPECT_EQ(nice(), previousNice);
+    }
+    {
+        packagemanager::PriorityProfile background;
+        background.enabled = true;
+        background.ioClass = packagemanager::IoClass::IDLE;
+        background.ioLevel = 7;
+        background.nice = 15;
+        packagemanager::ScopedThreadPriority scopedPriority{background};
+        EXPECT_EQ(ioPriority() >> 13, 3);
+        if (geteuid() == 0)
+        {
+            EXPECT_EQ(nice(), 15);
+        }
+    }
+    EXPECT_EQ(ioPriority(), previousIoPriority);
+    // the nice value is only changed if it can be restored
+    EXPECT_EQ(nice(), previousNice);
+}
+
+TEST_F(PackageImplTest, BackgroundJobPausesWhileInteractive)
+{
+    using std::chrono::milliseconds;
+    packagemanager::IoScheduler scheduler;
+    scheduler.configure(milliseconds(200), milliseconds(10000));
+
+    packagemanager::IoScheduler::BackgroundJob job{scheduler};
+    job.checkpoint();
+    EXPECT_EQ(job.pauses(), 0u);
+
+    // paused until the window of the launch closed
+    scheduler.noteInteractive();
+    job.checkpoint();
+    EXPECT_EQ(job.pauses(), 1u);
+    EXPECT_GE(job.paused().count(), 150);
+    job.checkpoint();
+    EXPECT_EQ(job.pauses(), 1u);
+
+    // launches can not hold a job back longer than its budget
+    scheduler.configure(milliseconds(5000), milliseconds(100));
+    packagemanager::IoScheduler::BackgroundJob limited{scheduler};
+    scheduler.noteInteractive();
+    auto start = std::chrono::steady_clock::now();
+    limited.checkpoint();
+    limited.checkpoint();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, milliseconds(1000));
+    EXPECT_EQ(limited.pauses(), 1u);
+
+    auto stats = scheduler.getStats();
+    EXPECT_EQ(stats.interactive, 2u);
+    EXPECT_EQ(stats.pauses, 2u);
+    EXPECT_GE(stats.pausedMs, 250u);
+}
+
+TEST_F(PackageImplTest, StatementCacheReusesPreparedStatements)
+{
+    sqlite3 *connection{};
+    ASSERT_EQ(sqlite3_open(":memory:", &connection), SQLITE_OK);
+    packagemanager::StatementCache cache;
+    cache.reset(connection);
+
+    const std::string query{"SELECT ?1;"};
+    sqlite3_stmt *first{};
+    {
+        packagemanager::StatementCache::Statement stmt{cache, query};
+        first = stmt;
+        sqlite3_bind_int(stmt, 1, 42);
+        ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+        EXPECT_EQ(sqlite3_column_int(stmt, 0), 42);
+    }
+    {
+        // reset with its bindings cleared
+        packagemanager::StatementCache::Statement stmt{cache, query};
+        EXPECT_EQ(static_cast<sqlite3_stmt *>(stmt), first);
+        ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+        EXPECT_EQ(sqlite3_column_type(stmt, 0), SQLITE_NULL);
+
+        // a statement in use is not handed out twice
+        packagemanager::StatementCache::Statement concurrent{cache, query};
+        EXPECT_NE(static_cast<sqlite3_stmt *>(concurrent), first);
+    }
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_THROW(packagemanager::StatementCache::Statement(cache, "SELECT FROM;"), packagemanager::DataStorageError);
+
+    cache.reset(nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(sqlite3_close(connection), SQLITE_OK);
+}
+
+TEST_F(PackageImplTest, DatabaseProfileSetsJournalMode)
+{
+    std::string configStr = configFor(R"(,"database":{"journalMode":"wal","mmapSizeKB":1024,"tempStore":"memory"})");
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    auto journalMode = [this]()
+    {
+        sqlite3 *db{};
+        EXPECT_EQ(sqlite3_open((testRoot + "/0/apps.db").c_str(), &db), SQLITE_OK);
+        std::string mode;
+        sqlite3_exec(db, "PRAGMA journal_mode;", [](void *mode, int, char **values, char **) -> int
+        {
+            *static_cast<std::string *>(mode) = values[0];
+            return 0;
+        }, &mode, nullptr);
+        sqlite3_close(db);
+        return mode;
+    };
+    EXPECT_EQ(journalMode(), "wal");
+
+    packagemanager::ConfigMetaData confMetadata;
+    packagemanager::NameValues metadata = {{"type", "application/dac.native"}, {"appName", "wal"}};
+    ASSERT_EQ(system(("mkdir -p " + testRoot + "/wal_bundle && echo {} > " + testRoot + "/wal_bundle/config.json && tar czf " + testRoot + "/wal_bundle.tar.gz -C " + testRoot + "/wal_bundle .").c_str()), 0);
+    ASSERT_EQ(packageImpl.Install("com.rdk.wal", "1.0", metadata, testRoot + "/wal_bundle.tar.gz", confMetadata), packagemanager::Result::SUCCESS);
+
+    // the default profile switches the file back to a rollback journal
+    configStr = configFor();
+    configMetadata.clear();
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+    EXPECT_EQ(journalMode(), "delete");
+    EXPECT_EQ(configMetadata.count({"com.rdk.wal", "1.0"}), 1u);
+    EXPECT_EQ(packageImpl.Uninstall("com.rdk.wal"), packagemanager::Result::SUCCESS);
+}
+
+TEST_F(PackageImplTest, ConnectionPoolReadsWhileWriting)
+{
+    packagemanager::ConnectionPool pool;
+    pool.open(testRoot + "/pool.db", 2);
+    auto count = [](sqlite3 *db)
+    {
+        int rows{-1};
+        sqlite3_exec(db, "SELECT COUNT(*) FROM t;", [](void *rows, int, char **values, char **) -> int
+        {
+            *static_cast<int *>(rows) = atoi(values[0]);
+            return 0;
+        }, &rows, nullptr);
+        return rows;
+    };
+    {
+        auto writer = pool.writer();
+        ASSERT_EQ(sqlite3_exec(writer, "PRAGMA journal_mode = WAL; CREATE TABLE t(x); BEGIN; INSERT INTO t VALUES(1);", nullptr, nullptr, nullptr), SQLITE_OK);
+
+        // the writing thread reads its own uncommitted row
+        EXPECT_EQ(count(pool.reader()), 1);
+
+        // other threads read the last commit without waiting for the writer
+        auto readers = std::async(std::launch::async, [&]()
+        {
+            auto first = pool.reader();
+            auto second = pool.reader();
+            return count(first) + count(second);
+        });
+        ASSERT_EQ(readers.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(readers.get(), 0);
+        ASSERT_EQ(sqlite3_exec(writer, "COMMIT;", nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+    EXPECT_EQ(count(pool.reader()), 1);
+    EXPECT_EQ(pool.openReaders(), 2u);
+    EXPECT_EQ(sqlite3_exec(pool.reader(), "INSERT INTO t VALUES(2);", nullptr, nullptr, nullptr), SQLITE_READONLY);
+    pool.close();
+}
+
+TEST_F(PackageImplTest, CatalogQueriesUseAppIdIndex)
+{
+    std::string configStr = configFor();
+    packagemanager::ConfigMetadataArray configMetadata;
+    ASSERT_EQ(packageImpl.Initialize(configStr, configMetadata), packagemanager::Result::SUCCESS);
+
+    sqlite3 *db{};
+    ASSERT_EQ(sqlite3_open((testRoot + "/0/apps.db").c_str(), &db), SQLITE_OK);
+    auto queryPlan = [db](const std::string &sql)
+    {
+        std::string plan;
+        sqlite3_stmt *stmt{};
+        EXPECT_EQ(sqlite3_prepare_v2(db, ("EXPLAIN QUERY PLAN " + sql).c_str(), -1, &stmt, nullptr), SQLITE_OK) << sql;
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            plan += reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+            plan += '\n';
+        }
+        sqlite3_finalize(stmt);
+        return plan;
+    };
+
+    // masks: bit 0 type, bit 1 app_id, bit 2 version
+    const std::string appIdSearch{"sqlite_autoindex_apps_1 (app_id=?)"};
+    for (auto mask : {2u, 3u})
+    {
+        auto plan = queryPlan(packagemanager::CatalogQueries::APP_DATA.sql(mask));
+        EXPECT_NE(plan.find(appIdSearch), std::string::npos) << plan;
+        plan = queryPlan(packagemanager::CatalogQueries::DATA_PATHS.sql(mask));
+        EXPECT_NE(plan.find(appIdSearch), std::string::npos) << plan;
+    }
+    for (auto mask : {2u, 6u})
+    {
+        for (const auto &sql : {packagemanager::CatalogQueries::APPS_PATHS.sql(mask), packagemanager::CatalogQueries::APPS_LOCATIONS.sql(mask),
+                                packagemanager::CatalogQueries::APP_DETAILS.sql(mask), packagemanager::CatalogQueries::APP_DETAILS_OUTER_JOIN.sql(mask)})
+        {
+            auto plan = queryPlan(sql);
+            EXPECT_NE(plan.find(appIdSearch), std::string::npos) << sql << '\n' << plan;
+            EXPECT_EQ(plan.find("SCAN"), std::string::npos) << sql << '\n' << plan;
+        }
+    }
+    EXPECT_NE(queryPlan(packagemanager::CatalogQueries::APPS_PATHS.sql(6u)).find("(app_idx=? AND version=?)"), std::string::npos);
+    sqlite3_close(db);
+}
+
+TEST_F(PackageImplTest, TransactionCommitsAllOrNothing)
+{
+    auto sqlStorage = openStorage();
+    packagemanager::DataStorage &storage = *sqlStorage;
+    addApp(storage, "com.rdk.tx", "1.0");
+
+    const packagemanager::DataStorage::MetadataValues values{{"public.first", "1"}, {"public.second", "2"}};
+    {
+        auto transaction = storage.BeginTransaction();
+        storage.SetMetadata(APP_TYPE, "com.rdk.tx", "1.0", values);
+        storage.RemoveInstalledApp(APP_TYPE, "com.rdk.tx", "1.0");
+        EXPECT_FALSE(storage.IsAppInstalled(APP_TYPE, "com.rdk.tx", "1.0"));
+        // not committed, the nested writes above are rolled back with it
+    }
+    EXPECT_TRUE(storage.IsAppInstalled(APP_TYPE, "com.rdk.tx", "1.0"));
+    EXPECT_TRUE(storage.GetMetadata(APP_TYPE, "com.rdk.tx", "1.0").metadata.empty());
+
+    storage.SetMetadata(APP_TYPE, "com.rdk.tx", "1.0", values);
+    EXPECT_EQ(storage.GetMetadata(APP_TYPE, "com.rdk.tx", "1.0").metadata.size(), 2u);
+
+    // an app that is not installed fails the first row and leaves nothing behind
+    EXPECT_THROW(storage.SetMetadata(APP_TYPE, "com.rdk.missing", "1.0", values), packagemanager::DataStorageError);
+    EXPECT_EQ(storage.GetMetadata(APP_TYPE, "com.rdk.tx", "1.0").metadata.size(), 2u);
+}
+
+TEST_F(PackageImplTest, AppUsageIsAccountedPerVersion)
+{
+    auto sqlStorage = openStorage();
+    packagemanager::DataStorage &storage = *sqlStorage;
+    const std::string &type = APP_TYPE;
+    addApp(storage, "com.rdk.usage", "1.0");
+    addApp(storage, "com.rdk.usage", "2.0", "", "usb");
+
+    packagemanager::DataStorage::AppUsage usage;
+    EXPECT_FALSE(storage.GetAppUsage(type, "com.rdk.usage", "1.0", usage));
+
+    std::vector<packagemanager::Filesystem::FileUsage> manifest(2);
+    manifest[0].path = "bin/app";
+    manifest[0].size = 5000;
+    manifest[0].blocks = 16;
+    manifest[1].path = "lib/libapp.so";
+    manifest[1].size = 100;
+    manifest[1].blocks = 8;
+    storage.SetAppUsage(type, "com.rdk.usage", "1.0", manifest);
+    storage.SetAppUsage(type, "com.rdk.usage", "2.0", std::vector<packagemanager::Filesystem::FileUsage>(1, manifest[0]));
+
+    ASSERT_TRUE(storage.GetAppUsage(type, "com.rdk.usage", "1.0", usage));
+    EXPECT_EQ(usage.bytes, 5100u);
+    EXPECT_EQ(usage.blocks, 24u);
+    EXPECT_EQ(storage.GetTotalUsage().bytes, 10100u);
+    EXPECT_EQ(storage.GetVolumeUsage("usb").blocks, 16u);
+
+    // a new manifest replaces the old one
+    storage.SetAppUsage(type, "com.rdk.usage", "1.0", std::vector<packagemanager::Filesystem::FileUsage>(1, manifest[1]));
+    ASSERT_TRUE(storage.GetAppUsage(type, "com.rdk.usage", "1.0", usage));
+    EXPECT_EQ(usage.bytes, 100u);
+    EXPECT_EQ(storage.GetTotalUsage().bytes, 5100u);
+
+    storage.RemoveInstalledApp(type, "com.rdk.usage", "2.0");
+    EXPECT_EQ(storage.GetTotalUsage().blocks, 8u);
+}
+
+TEST_F(PackageImplTest, InstalledAppsListedWithLocations)
+{
+    auto sqlStorage = openStorage();
+    packagemanager::DataStorage &storage = *sqlStorage;
+    const std::string &type = APP_TYPE;
+    addApp(storage, "com.rdk.first", "1.0");
+    addApp(storage, "com.rdk.first", "2.0", "", "usb");
+    addApp(storage, "com.rdk.second", "1.0");
+    storage.SetAppUsage(type, "com.rdk.second", "1.0", {});
+    storage.SetHibernated("com.rdk.first", "1.0", true);
+
+    auto apps = storage.GetInstalledApps();
+    ASSERT_EQ(apps.size(), 3u);
+    std::sort(apps.begin(), apps.end(), [](const packagemanager::DataStorage::InstalledApp &a, const packagemanager::DataStorage::InstalledApp &b)
+    {
+        return a.details.id + a.details.version < b.details.id + b.details.version;
+    });
+    EXPECT_EQ(apps[0].details.type, type);
+    EXPECT_EQ(apps[0].details.appName, "first");
+    EXPECT_EQ(apps[0].location.path, "com.rdk.first/1.0");
+    EXPECT_TRUE(apps[0].location.hibernated);
+    EXPECT_FALSE(apps[0].usageRecorded);
+    EXPECT_EQ(apps[1].location.volume, "usb");
+    EXPECT_FALSE(apps[1].location.hibernated);
+    EXPECT_EQ(apps[2].details.id, "com.rdk.second");
+    EXPECT_TRUE(apps[2].usageRecorded);
+}
+
+TEST_F(PackageImplTest, VisitAppDetailsStopsEarly)
+{
+    auto sqlStorage = openStorage();
+    packagemanager::DataStorage &storage = *sqlStorage;
+    const std::string &type = APP_TYPE;
+    addApp(storage, "com.rdk.visit", "1.0", "games");
+    addApp(storage, "com.rdk.visit", "2.0", "games");
+    addApp(storage, "com.rdk.removed", "1.0");
+    storage.RemoveInstalledApp(type, "com.rdk.removed", "1.0");
+
+    unsigned int rows{};
+    storage.VisitAppDetails([&rows, &type](const packagemanager::DataStorage::AppDetailsView &row)
+    {
+        ++rows;
+        EXPECT_TRUE(row.type == type);
+        EXPECT_TRUE(row.id == "com.rdk.visit");
+        EXPECT_TRUE(row.category == "games");
+        EXPECT_EQ(row.version.size, 3u);
+        return false;
+    }, false, type, "com.rdk.visit");
+    EXPECT_EQ(rows, 1u);
+
+    std::vector<std::string> versions;
+    storage.VisitAppDetails([&versions](const packagemanager::DataStorage::AppDetailsView &row)
+    {
+        versions.push_back(row.id.str() + ':' + row.version.str());
+        return true;
+    }, true);
+    std::sort(versions.begin(), versions.end());
+    EXPECT_EQ(versions, (std::vector<std::string>{"com.rdk.removed:", "com.rdk.visit:1.0", "com.rdk.visit:2.0"}));
+    EXPECT_EQ(storage.GetAppDetailsListOuterJoin().size(), 3u);
+    EXPECT_EQ(storage.GetAppDetailsList().size(), 2u);
+}
+
+TEST_F(PackageImplTest, CatalogSnapshotInternsStrings)
+{
+    auto sqlStorage = openStorage();
+    packagemanager::DataStorage &storage = *sqlStorage;
+    const std::string &type = APP_TYPE;
+    addApp(storage, "com.rdk.one", "1.0", "games");
+    addApp(storage, "com.rdk.two", "1.0", "games");
+
+    auto generation = storage.GetGeneration();
+    auto snapshot = packagemanager::CatalogSnapshot::build(storage);
+    EXPECT_EQ(snapshot->generation(), generation);
+    ASSERT_EQ(snapshot->size(), 2u);
+    // type, version and category are stored once for both rows, the url and volume are empty
+    EXPECT_EQ(snapshot->arenaSize(), type.size() + std::string{"com.rdk.onecom.rdk.two1.0onetwogamescom.rdk.one/1.0com.rdk.two/1.0"}.size());
+    EXPECT_EQ((*snapshot)[0].type.data, (*snapshot)[1].type.data);
+    EXPECT_EQ((*snapshot)[0].category.data, (*snapshot)[1].category.data);
+
+    auto list = storage.GetAppDetailsListOuterJoin();
+    ASSERT_EQ(list.size(), snapshot->size());
+    for (std::size_t row = 0; row < list.size(); ++row)
+    {
+        auto details = (*snapshot)[row].str();
+        EXPECT_EQ(details.id, list[row].id);
+        EXPECT_EQ(details.version, list[row].version);
+        EXPECT_EQ(details.appName, list[row].appName);
+    }
+
+    storage.GetAppDetailsList();
+    storage.IsAppInstalled(type, "com.rdk.one", "1.0");
+    storage.SetLastLocked("com.rdk.one", "1.0", 42);
+    storage.SetMetadata(type, "com.rdk.one", "1.0", "key", "value");
+    EXPECT_EQ(storage.GetGeneration(), generation);
+    storage.RemoveInstalledApp(type, "com.rdk.two", "1.0");
+    EXPECT_NE(storage.GetGeneration(), generation);
+    // the snapshot is unchanged by the write
+    EXPECT_TRUE((*snapshot)[1].version == "1.0");
+}
+
+TEST_F(PackageImplTest, CatalogSnapshotIndexesInstalledVersions)
+{
+    auto sqlStorage = openStorage();
+    packagemanager::DataStorage &storage = *sqlStorage;
+    const std::string &type = APP_TYPE;
+    addApp(storage, "com.rdk.mirror", "1.0");
+    addApp(storage, "com.rdk.mirror", "2.0", "", "usb");
+    addApp(storage, "com.rdk.gone", "1.0");
+    storage.RemoveInstalledApp(type, "com.rdk.gone", "1.0");
+    storage.SetHibernated("com.rdk.mirror", "1.0", true);
+
+    auto snapshot = packagemanager::CatalogSnapshot::build(storage);
+    const auto npos = packagemanager::CatalogSnapshot::npos;
+    auto row = snapshot->find("com.rdk.mirror", "2.0");
+    ASSERT_NE(row, npos);
+    auto location = (*snapshot)[row].location();
+    EXPECT_EQ(location.volume, "usb");
+    EXPECT_EQ(location.path, "com.rdk.mirror/2.0");
+    EXPECT_FALSE(location.hibernated);
+    row = snapshot->find("com.rdk.mirror", "1.0");
+    ASSERT_NE(row, npos);
+    EXPECT_TRUE((*snapshot)[row].hibernated);
+    EXPECT_EQ(snapshot->find("com.rdk.mirror", "3.0"), npos);
+
+    // the app without installed version still has its type, but no version
+    row = snapshot->find("com.rdk.gone");
+    ASSERT_NE(row, npos);
+    EXPECT_TRUE((*snapshot)[row].type == type);
+    EXPECT_EQ(snapshot->find("com.rdk.gone", "1.0"), npos);
+    EXPECT_EQ(snapshot->find("com.rdk.missing"), npos);
+}
+
+TEST_F(PackageImplTest, LockKeepsCatalogSnapshot)
+{
+    packagemanager::Executor executor;
+    ASSERT_EQ(executor.Configure(configFor()), 0u);
+
+    std::string bundlePath = testRoot + "/bundle";
+    ASSERT_EQ(system(("mkdir -p " + bundlePath).c_str()), 0);
+    std::ofstream(bundlePath + "/config.json") << "{}";
+    ASSERT_EQ(system(("tar czf " + testRoot + "/bundle.tar.gz -C " + bundlePath + " .").c_str()), 0);
+    ASSERT_EQ(executor.Install(APP_TYPE, "com.rdk.steady", "1.0", testRoot + "/bundle.tar.gz", "steady", ""), 0u);
+
+    // the last locked time and the usage do not stale the catalog the launch path reads
+    auto snapshot = executor.GetCatalogSnapshot();
+    ASSERT_NE(snapshot->find("com.rdk.steady", "1.0"), packagemanager::CatalogSnapshot::npos);
+    ASSERT_EQ(executor.Lock("com.rdk.steady", "1.0"), 0u);
+    EXPECT_EQ(executor.Unlock("com.rdk.steady", "1.0"), 0u);
+    EXPECT_EQ(executor.GetCatalogSnapshot().get(), snapshot.get());
+
+    EXPECT_EQ(executor.Uninstall(APP_TYPE, "com.rdk.steady", "1.0", "full"), 0u);
+    EXPECT_NE(executor.GetCatalogSnapshot().get(), snapshot.get());
+}